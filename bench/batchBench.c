@@ -0,0 +1,174 @@
+/*
+ * Batched insert benchmark: wtAdd one key at a time against wtAddBatch,
+ * which prefetches the buckets of a whole batch before resolving it.
+ *
+ * Usage: bench/batchBench [keys [operations]]
+ *
+ * Builds a table of distinct synthetic keys (16M by default, well over a
+ * gigabyte with its nodes and words, so far larger than the last level
+ * cache), timing the build both ways. Then counts the given number of
+ * operations (32M by default) on uniformly random existing keys, the case
+ * where nearly every bucket and node access misses the cache, with wtAdd
+ * and with wtAddBatch at batch sizes 16, 32 and 64. The keys are generated
+ * up front so only the table work is timed.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "wordTable.h"
+#include "getWord.h"
+#include "myMacros.h"
+
+#define KEY_LENGTH 12
+
+static unsigned sizes[] = {
+   53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593,
+   49157, 98317, 196613, 393241, 786433, 1572869, 3145739, 6291469,
+   12582917, 25165843, 50331653, 100663319, 201326611, 402653189,
+   805306457, 1610612741, 4294967295
+};
+
+static unsigned long lcgState = 42;
+
+static unsigned random32(void)
+{
+   lcgState = lcgState * 6364136223846793005UL + 1442695040888963407UL;
+   return (unsigned)(lcgState >> 32);
+}
+
+static double now(void)
+{
+   struct timespec time;
+
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/* Key i is its number in base 26 letters, scrambled so neighbours in the
+ * key array are not neighbours in any other sense.
+ */
+static Word *makeKeys(unsigned count)
+{
+   Word *keys;
+   Byte *bytes;
+   unsigned i, j, value;
+
+   MY_MALLOC(keys, count * sizeof(Word));
+   MY_MALLOC(bytes, (size_t)count * KEY_LENGTH);
+   for(i = 0; i < count; i++) {
+      value = i * 2654435761u;
+      for(j = 0; j < KEY_LENGTH; j++) {
+         bytes[(size_t)i * KEY_LENGTH + j] = 'a' + value % 26;
+         value = value / 26 + (j == 6 ? i : 0);
+      }
+      keys[i].bytes = bytes + (size_t)i * KEY_LENGTH;
+      keys[i].length = KEY_LENGTH;
+      keys[i].borrowed = 1;
+   }
+   return keys;
+}
+
+static wtTable *build(Word *keys, unsigned count, unsigned batch,
+   double *seconds)
+{
+   int numSizes = sizeof(sizes) / sizeof(*sizes);
+   wtTable *table = wtCreate(sizes, numSizes, 1);
+   Word **pointers;
+   unsigned *freqs;
+   unsigned i, n;
+   double start;
+
+   MY_MALLOC(pointers, count * sizeof(Word *));
+   MY_MALLOC(freqs, count * sizeof(unsigned));
+   for(i = 0; i < count; i++)
+      pointers[i] = &keys[i];
+
+   start = now();
+   if(batch == 0)
+      for(i = 0; i < count; i++)
+         wtAdd(table, pointers[i]);
+   else
+      for(i = 0; i < count; i += n) {
+         n = MIN(batch, count - i);
+         wtAddBatch(table, pointers + i, n, freqs + i);
+      }
+   *seconds = now() - start;
+
+   free(pointers);
+   free(freqs);
+   return table;
+}
+
+static double update(wtTable *table, Word **ops, unsigned count,
+   unsigned batch)
+{
+   unsigned freqs[64];
+   unsigned i, n;
+   double start = now();
+
+   if(batch == 0)
+      for(i = 0; i < count; i++)
+         wtAdd(table, ops[i]);
+   else
+      for(i = 0; i < count; i += n) {
+         n = MIN(batch, count - i);
+         wtAddBatch(table, ops + i, n, freqs);
+      }
+   return now() - start;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned numKeys = 16u << 20, numOps = 32u << 20;
+   unsigned batches[] = {0, 16, 32, 64};
+   unsigned i, b;
+   double seconds, single = 0;
+   Word *keys;
+   Word **ops;
+   wtTable *table;
+
+   if(argc > 1)
+      numKeys = strtoul(argv[1], NULL, 10);
+   if(argc > 2)
+      numOps = strtoul(argv[2], NULL, 10);
+   if(numKeys == 0 || numOps == 0) {
+      fprintf(stderr, "Usage: batchBench [keys [operations]]\n");
+      return EXIT_FAILURE;
+   }
+
+   keys = makeKeys(numKeys);
+   MY_MALLOC(ops, numOps * sizeof(Word *));
+   for(i = 0; i < numOps; i++)
+      ops[i] = &keys[random32() % numKeys];
+
+   /* one table per build, freed before the next so only one is resident */
+   for(b = 0; b < sizeof(batches) / sizeof(*batches); b += 3) {
+      table = build(keys, numKeys, batches[b], &seconds);
+      printf("build %u keys, %-12s %7.3f s  %6.1f ns/key  (%u unique)\n",
+         numKeys, batches[b] ? "batch 64" : "wtAdd", seconds,
+         seconds * 1e9 / numKeys, wtUniqueEntries(table));
+      wtDestroy(table);
+   }
+
+   table = build(keys, numKeys, 64, &seconds);
+   for(b = 0; b < sizeof(batches) / sizeof(*batches); b++) {
+      seconds = update(table, ops, numOps, batches[b]);
+      if(b == 0)
+         single = seconds;
+      printf("update %u random keys, ", numOps);
+      if(batches[b] == 0)
+         printf("wtAdd     ");
+      else
+         printf("batch %-4u", batches[b]);
+      printf(" %7.3f s  %6.1f ns/op  x%.2f\n", seconds,
+         seconds * 1e9 / numOps, single / seconds);
+   }
+
+   wtDestroy(table);
+   free(ops);
+   free(keys[0].bytes);
+   free(keys);
+   return EXIT_SUCCESS;
+}
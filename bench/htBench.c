@@ -0,0 +1,541 @@
+/*
+ * Workload benchmark for the hashTable.h API: htCreate, htAdd, htLookUp,
+ * htToArray, htMetrics and htDestroy on synthetic keys.
+ *
+ * Usage: bench/htBench [keys [operations [workload...]]]
+ *
+ * The workloads are uniform (distinct random keys of 7 to 15 letters added
+ * in random order), zipf (operations adds drawn from a Zipf distribution
+ * over keys words, the shape of natural text), sequential (w1, w2, ... added
+ * in order) and long (255 byte keys sharing a 248 byte prefix). Each one
+ * builds a table and then runs operations lookups at 100%, 50% and 0% hits,
+ * the misses being keys of the same shape that were never added. keys
+ * defaults to 1M and operations to 2M; all four workloads run by default.
+ *
+ * Every call is timed on its own and the timer's cost, measured up front,
+ * is taken off each sample before the percentiles. An add that changes
+ * htCapacity is a rehash pause and is reported separately too. Each
+ * workload runs in a child process, so the peak resident memory of the
+ * table (VmHWM from /proc, reset once the keys are made) is not mixed with
+ * that of the workloads before it.
+ *
+ * Only hashTable.h is used, so the benchmark runs as is against any
+ * implementation of it:
+ *
+ *    make bench/htBench HT_BACKEND="myTable.o"
+ *
+ * Built with HT_FREEZE defined, as it is by default, each workload then
+ * freezes its table with htFreeze (frozenTable.h) and runs the lookups and
+ * htToArray again on the frozen layout; define it away for a backend
+ * without it:
+ *
+ *    make bench/htBench HT_BACKEND="myTable.o" HT_BENCH_FLAGS=
+ *
+ * The keys are malloc'ed one by one, as htDestroy frees them.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "hashTable.h"
+#ifdef HT_FREEZE
+#include "frozenTable.h"
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define LOAD_FACTOR 0.75
+#define ZIPF_EXPONENT 1.0
+#define LONG_PREFIX 248
+#define CORE_LENGTH 7
+#define TIMER_SAMPLES 10000
+
+#define MB (1024.0 * 1024.0)
+
+typedef enum {UNIFORM, ZIPF, SEQUENTIAL, LONG_KEYS, WORKLOADS} Workload;
+
+static const char *workloadNames[WORKLOADS] = {
+   "uniform", "zipf", "sequential", "long"
+};
+
+typedef struct {
+   unsigned length;
+   unsigned char *bytes;
+} Key;
+
+/* Per-call times of one phase, in nanoseconds. */
+typedef struct {
+   unsigned *nanos;
+   unsigned count;
+   double seconds;
+} Samples;
+
+static unsigned sizes[] = {
+   53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593,
+   49157, 98317, 196613, 393241, 786433, 1572869, 3145739, 6291469,
+   12582917, 25165843, 50331653, 100663319, 201326611, 402653189,
+   805306457, 1610612741, 4294967295
+};
+
+static unsigned long lcgState = 42;
+static unsigned long timerCost;
+
+static unsigned random32(void)
+{
+   lcgState = lcgState * 6364136223846793005UL + 1442695040888963407UL;
+   return (unsigned)(lcgState >> 32);
+}
+
+static unsigned long nanos(void)
+{
+   struct timespec time;
+
+   clock_gettime(CLOCK_MONOTONIC, &time);
+   return time.tv_sec * 1000000000UL + time.tv_nsec;
+}
+
+/* The median cost of reading the clock, which every sample includes once. */
+static unsigned long measureTimer(void)
+{
+   static unsigned long costs[TIMER_SAMPLES];
+   unsigned long start, swap;
+   int i, j;
+
+   for(i = 0; i < TIMER_SAMPLES; i++) {
+      start = nanos();
+      costs[i] = nanos() - start;
+   }
+   /* a partial selection sort up to the median is plenty for 10k */
+   for(i = 0; i <= TIMER_SAMPLES / 2; i++)
+      for(j = i + 1; j < TIMER_SAMPLES; j++)
+         if(costs[j] < costs[i]) {
+            swap = costs[i];
+            costs[i] = costs[j];
+            costs[j] = swap;
+         }
+   return costs[TIMER_SAMPLES / 2];
+}
+
+static void *allocate(size_t size)
+{
+   void *memory = malloc(size);
+
+   if(memory == NULL) {
+      perror(NULL);
+      exit(EXIT_FAILURE);
+   }
+   return memory;
+}
+
+static unsigned hashKey(const void *data)
+{
+   const Key *key = data;
+   unsigned hash = 2166136261u, i;
+
+   for(i = 0; i < key->length; i++) {
+      hash ^= key->bytes[i];
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+static int compareKey(const void *data1, const void *data2)
+{
+   const Key *key1 = data1, *key2 = data2;
+   unsigned length = key1->length < key2->length ? key1->length
+      : key2->length;
+   int order = memcmp(key1->bytes, key2->bytes, length);
+
+   if(order != 0)
+      return order;
+   return (key1->length > key2->length) - (key1->length < key2->length);
+}
+
+/* Key i of the workload, in one allocation. Keys differ in their first
+ * CORE_LENGTH letters (after the prefix of long keys): i scrambled, in base
+ * 26, which is one to one for any 32 bit i.
+ */
+static Key *makeKey(Workload workload, unsigned i)
+{
+   unsigned char bytes[LONG_PREFIX + CORE_LENGTH + 8];
+   unsigned length = 0, value, padding = 0, j;
+   Key *key;
+
+   if(workload == SEQUENTIAL)
+      length = sprintf((char *)bytes, "w%u", i + 1);
+   else {
+      if(workload == LONG_KEYS)
+         for(; length < LONG_PREFIX; length++)
+            bytes[length] = 'a' + length % 26;
+      else
+         padding = random32() % 9;
+      value = i * 2654435761u;
+      for(j = 0; j < CORE_LENGTH; j++, value /= 26)
+         bytes[length++] = 'a' + value % 26;
+      for(j = 0; j < padding; j++)
+         bytes[length++] = 'a' + random32() % 26;
+   }
+
+   key = allocate(sizeof(Key) + length);
+   key->length = length;
+   key->bytes = (unsigned char *)(key + 1);
+   memcpy(key->bytes, bytes, length);
+   return key;
+}
+
+static void shuffle(Key **keys, unsigned count)
+{
+   unsigned i, j;
+   Key *swap;
+
+   for(i = count; i > 1; i--) {
+      j = random32() % i;
+      swap = keys[i - 1];
+      keys[i - 1] = keys[j];
+      keys[j] = swap;
+   }
+}
+
+/* The cumulative Zipf distribution over ranks 1 to count, normalized. */
+static double *zipfTable(unsigned count)
+{
+   double *cumulative = allocate(count * sizeof(double));
+   double sum = 0;
+   unsigned i;
+
+   for(i = 0; i < count; i++)
+      cumulative[i] = sum += 1 / pow(i + 1, ZIPF_EXPONENT);
+   for(i = 0; i < count; i++)
+      cumulative[i] /= sum;
+   return cumulative;
+}
+
+static unsigned zipfDraw(double *cumulative, unsigned count)
+{
+   double u = (random32() + 0.5) / 4294967296.0;
+   unsigned low = 0, high = count - 1, middle;
+
+   while(low < high) {
+      middle = low + (high - low) / 2;
+      if(cumulative[middle] < u)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   return low;
+}
+
+/* The lookups of one mix: hitPercent of them drawn from the adds, so hits
+ * follow the distribution of the adds, the rest keys never added.
+ */
+static void makeLookUps(Key **lookUps, unsigned count, int hitPercent,
+   Key **adds, unsigned numAdds, Key **misses, unsigned numMisses)
+{
+   unsigned i;
+
+   for(i = 0; i < count; i++)
+      if(random32() % 100 < (unsigned)hitPercent)
+         lookUps[i] = adds[random32() % numAdds];
+      else
+         lookUps[i] = misses[random32() % numMisses];
+}
+
+static void record(Samples *samples, unsigned long start, unsigned long end)
+{
+   unsigned long elapsed = end - start;
+
+   elapsed = elapsed > timerCost ? elapsed - timerCost : 0;
+   samples->nanos[samples->count++] = elapsed > 4294967295UL ? 4294967295u
+      : (unsigned)elapsed;
+}
+
+static int compareNanos(const void *a, const void *b)
+{
+   unsigned x = *(const unsigned *)a, y = *(const unsigned *)b;
+
+   return (x > y) - (x < y);
+}
+
+static unsigned percentile(Samples *samples, double fraction)
+{
+   return samples->nanos[(unsigned)(fraction * (samples->count - 1))];
+}
+
+/* Sorts the samples, so call it last. */
+static void printSamples(const char *name, Samples *samples)
+{
+   if(samples->count == 0)
+      return;
+   qsort(samples->nanos, samples->count, sizeof(unsigned), compareNanos);
+   printf("  %-16s %9u ops %7.1f ns/op  p50 %5u  p90 %5u  p99 %6u  "
+      "p99.9 %7u  max %9u\n", name, samples->count,
+      samples->seconds * 1e9 / samples->count, percentile(samples, 0.5),
+      percentile(samples, 0.9), percentile(samples, 0.99),
+      percentile(samples, 0.999), samples->nanos[samples->count - 1]);
+}
+
+/* Reads a "Name:   1234 kB" line of /proc/self/status, in bytes, -1 when
+ * there is none.
+ */
+static double readStatus(const char *name)
+{
+   FILE *status = fopen("/proc/self/status", "r");
+   char line[256];
+   double kilobytes = -1;
+   size_t length = strlen(name);
+
+   if(status == NULL)
+      return -1;
+   while(fgets(line, sizeof(line), status) != NULL)
+      if(!strncmp(line, name, length) && line[length] == ':') {
+         if(1 != sscanf(line + length + 1, "%lf", &kilobytes))
+            kilobytes = -1;
+         break;
+      }
+   fclose(status);
+   return kilobytes < 0 ? -1 : kilobytes * 1024;
+}
+
+/* Sets VmHWM back to the current VmRSS. Returns 0 if the kernel refused. */
+static int resetPeak(void)
+{
+   FILE *clear = fopen("/proc/self/clear_refs", "w");
+   int done;
+
+   if(clear == NULL)
+      return 0;
+   done = fputs("5", clear) >= 0;
+   return 0 == fclose(clear) && done;
+}
+
+/* Adds every key, timing each add. Adds that change the capacity are the
+ * rehash pauses.
+ */
+static void timeAdds(void *table, Key **adds, unsigned count,
+   Samples *samples)
+{
+   unsigned long start, end, first = nanos();
+   unsigned i, capacity = htCapacity(table), rehashes = 0;
+   double paused = 0, longest = 0;
+
+   samples->count = 0;
+   for(i = 0; i < count; i++) {
+      start = nanos();
+      htAdd(table, adds[i]);
+      end = nanos();
+      record(samples, start, end);
+      if(htCapacity(table) != capacity) {
+         capacity = htCapacity(table);
+         rehashes++;
+         paused += samples->nanos[i];
+         if(samples->nanos[i] > longest)
+            longest = samples->nanos[i];
+      }
+   }
+   samples->seconds = (nanos() - first) * 1e-9;
+
+   printSamples("htAdd", samples);
+   printf("  %-16s %9u     longest %.2f ms, total %.2f ms, capacity %u\n",
+      "rehash pauses", rehashes, longest * 1e-6, paused * 1e-6, capacity);
+}
+
+static void timeLookUps(const char *label, void *table, Key **lookUps,
+   unsigned count, int hitPercent, Samples *samples)
+{
+   unsigned long start, end, first = nanos();
+   unsigned i, found = 0;
+   char name[32];
+
+   samples->count = 0;
+   for(i = 0; i < count; i++) {
+      start = nanos();
+      found += htLookUp(table, lookUps[i]).frequency > 0;
+      end = nanos();
+      record(samples, start, end);
+   }
+   samples->seconds = (nanos() - first) * 1e-9;
+
+   sprintf(name, "%s %d%%", label, hitPercent);
+   printSamples(name, samples);
+   printf("  %-16s %9.1f %%\n", "found", 100.0 * found / count);
+}
+
+static void runWorkload(Workload workload, unsigned numKeys,
+   unsigned numOps)
+{
+   HTFunctions functions = {hashKey, compareKey, NULL};
+   int numSizes = sizeof(sizes) / sizeof(*sizes);
+   int mixes[] = {100, 50, 0};
+   unsigned numAdds = workload == ZIPF ? numOps : numKeys;
+   unsigned numMisses = numKeys < numOps ? numKeys : numOps;
+   unsigned i, count, numSamples = numAdds > numOps ? numAdds : numOps;
+   unsigned long start;
+   double *zipf, baseline, buildPeak, peak, frozen;
+   Key **keys, **adds, **misses, **lookUps[3];
+   Samples samples;
+   HTEntry *entries;
+   HTMetrics metrics;
+   void *table;
+   int m, reset;
+
+   lcgState = 42 + workload;
+   keys = allocate(numKeys * sizeof(Key *));
+   for(i = 0; i < numKeys; i++)
+      keys[i] = makeKey(workload, i);
+   misses = allocate(numMisses * sizeof(Key *));
+   for(i = 0; i < numMisses; i++)
+      misses[i] = makeKey(workload, numKeys + i);
+
+   adds = allocate(numAdds * sizeof(Key *));
+   if(workload == ZIPF) {
+      zipf = zipfTable(numKeys);
+      for(i = 0; i < numAdds; i++)
+         adds[i] = keys[zipfDraw(zipf, numKeys)];
+      free(zipf);
+   }
+   else {
+      memcpy(adds, keys, numKeys * sizeof(Key *));
+      if(workload != SEQUENTIAL)
+         shuffle(adds, numAdds);
+   }
+   for(m = 0; m < 3; m++) {
+      lookUps[m] = allocate(numOps * sizeof(Key *));
+      makeLookUps(lookUps[m], numOps, mixes[m], adds, numAdds, misses,
+         numMisses);
+   }
+
+   /* touched now so the samples are not part of the table's peak */
+   samples.nanos = allocate(numSamples * sizeof(unsigned));
+   memset(samples.nanos, 0, numSamples * sizeof(unsigned));
+
+   printf("%s: %u keys, %u adds, %u lookups per mix\n",
+      workloadNames[workload], numKeys, numAdds, numOps);
+
+   baseline = readStatus("VmRSS");
+   reset = resetPeak();
+   table = htCreate(&functions, sizes, numSizes, LOAD_FACTOR);
+   timeAdds(table, adds, numAdds, &samples);
+   buildPeak = readStatus("VmHWM");
+
+   for(m = 0; m < 3; m++)
+      timeLookUps("htLookUp", table, lookUps[m], numOps, mixes[m],
+         &samples);
+
+   start = nanos();
+   entries = htToArray(table, &count);
+   printf("  %-16s %9u     %.2f ms\n", "htToArray", count,
+      (nanos() - start) * 1e-6);
+   peak = readStatus("VmHWM");
+   free(entries);
+
+   start = nanos();
+   metrics = htMetrics(table);
+   printf("  %-16s %9u     %.2f ms, %u unique, longest chain %u, "
+      "average %.2f\n", "htMetrics", metrics.numberOfChains,
+      (nanos() - start) * 1e-6, htUniqueEntries(table),
+      metrics.maxChainLength, metrics.avgChainLength);
+
+   if(baseline >= 0 && peak >= 0 && reset)
+      printf("  %-16s %9.1f MB  %.1f bytes per unique key, %.1f MB with "
+         "htToArray\n", "peak memory", (buildPeak - baseline) / MB,
+         (buildPeak - baseline) / htUniqueEntries(table),
+         (peak - baseline) / MB);
+   else if(peak >= 0)
+      printf("  %-16s %9.1f MB  whole process, VmHWM could not be reset\n",
+         "peak memory", peak / MB);
+
+#ifdef HT_FREEZE
+   start = nanos();
+   htFreeze(table);
+   printf("  %-16s %9s     %.2f ms\n", "htFreeze", "",
+      (nanos() - start) * 1e-6);
+
+   for(m = 0; m < 3; m++)
+      timeLookUps("frozen", table, lookUps[m], numOps, mixes[m], &samples);
+
+   start = nanos();
+   entries = htToArray(table, &count);
+   printf("  %-16s %9u     %.2f ms\n", "htToArray frozen", count,
+      (nanos() - start) * 1e-6);
+   free(entries);
+
+   /* the freed nodes are resident until malloc gives them back */
+#ifdef __GLIBC__
+   malloc_trim(0);
+#endif
+   frozen = readStatus("VmRSS");
+   if(baseline >= 0 && frozen >= 0)
+      printf("  %-16s %9.1f MB  %.1f bytes per unique key\n",
+         "frozen memory", (frozen - baseline) / MB,
+         (frozen - baseline) / htUniqueEntries(table));
+#endif
+
+   /* the table owns the added keys now and frees them */
+   start = nanos();
+   htDestroy(table);
+   printf("  %-16s %9s     %.2f ms\n", "htDestroy", "",
+      (nanos() - start) * 1e-6);
+}
+
+static int findWorkload(const char *name)
+{
+   int w;
+
+   for(w = 0; w < WORKLOADS; w++)
+      if(!strcmp(name, workloadNames[w]))
+         return w;
+   return -1;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned numKeys = 1u << 20, numOps = 2u << 20;
+   int selected[WORKLOADS], numSelected = 0, i, status;
+   pid_t child;
+
+   if(argc > 1)
+      numKeys = strtoul(argv[1], NULL, 10);
+   if(argc > 2)
+      numOps = strtoul(argv[2], NULL, 10);
+   for(i = 3; i < argc && numSelected < WORKLOADS; i++)
+      if(0 > (selected[numSelected++] = findWorkload(argv[i])))
+         break;
+   if(numKeys == 0 || numOps == 0 || i < argc) {
+      fprintf(stderr, "Usage: htBench [keys [operations [workload...]]]\n"
+         "   workloads: uniform zipf sequential long\n");
+      return EXIT_FAILURE;
+   }
+   if(numSelected == 0)
+      for(; numSelected < WORKLOADS; numSelected++)
+         selected[numSelected] = numSelected;
+
+   timerCost = measureTimer();
+   printf("timer cost %lu ns, taken off every sample\n", timerCost);
+
+   for(i = 0; i < numSelected; i++) {
+      fflush(stdout);
+      if(0 > (child = fork())) {
+         perror("fork");
+         return EXIT_FAILURE;
+      }
+      if(child == 0) {
+         runWorkload(selected[i], numKeys, numOps);
+         fflush(stdout);
+         _exit(EXIT_SUCCESS);
+      }
+      if(child != waitpid(child, &status, 0) || !WIFEXITED(status)
+         || WEXITSTATUS(status) != EXIT_SUCCESS) {
+         fprintf(stderr, "htBench: %s failed\n",
+            workloadNames[selected[i]]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   return EXIT_SUCCESS;
+}
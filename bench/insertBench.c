@@ -0,0 +1,116 @@
+/*
+ * Insert loop benchmark: the generic table from hashTable.h, which hashes and
+ * compares through HTFunctions, against the Word-specialized wtTable.
+ *
+ * Usage: bench/insertBench file [rounds]
+ *
+ * The file is tokenized once up front so only the insert loop is timed. Each
+ * round inserts every token into a fresh table of each kind and the best
+ * time of the rounds is reported. The tokens stay owned by the benchmark, so
+ * the tables are not destroyed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hashTable.h"
+#include "wordTable.h"
+#include "getWord.h"
+#include "myMacros.h"
+
+static unsigned sizes[] = {
+   53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593,
+   49157, 98317, 196613, 393241, 786433, 1572869, 3145739, 6291469,
+   12582917, 25165843, 50331653, 100663319, 201326611, 402653189,
+   805306457, 1610612741, 4294967295
+};
+
+static Word *readTokens(const char *fname, unsigned *count)
+{
+   FILE *file = fopen(fname, "r");
+   Word *tokens;
+   unsigned alloc = 1024;
+   Byte *word;
+   unsigned wordLength;
+   int hasPrintable;
+   int ch;
+
+   if(file == NULL) {
+      perror(fname);
+      exit(EXIT_FAILURE);
+   }
+
+   MY_MALLOC(tokens, alloc * sizeof(Word));
+   *count = 0;
+   do {
+      ch = getWord(file, &word, &wordLength, &hasPrintable);
+      if(!hasPrintable) {
+         if(wordLength > 0)
+            free(word);
+         continue;
+      }
+      if(*count == alloc) {
+         alloc <<= 1;
+         if(NULL == (tokens = realloc(tokens, alloc * sizeof(Word)))) {
+            perror(NULL);
+            exit(EXIT_FAILURE);
+         }
+      }
+      tokens[*count].bytes = word;
+      tokens[*count].borrowed = 0;
+      tokens[(*count)++].length = wordLength;
+   } while(ch != EOF);
+
+   fclose(file);
+   return tokens;
+}
+
+static double seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+   HTFunctions funcs = {hashWord, compareWord, NULL};
+   int numSizes = sizeof(sizes) / sizeof(*sizes);
+   int rounds = 3, r;
+   unsigned count, i;
+   double generic = 0.0, specialized = 0.0, t;
+   clock_t start;
+   Word *tokens;
+   void *ht = NULL;
+   wtTable *wt = NULL;
+
+   if(argc < 2) {
+      fprintf(stderr, "Usage: insertBench file [rounds]\n");
+      return EXIT_FAILURE;
+   }
+   if(argc > 2 && (rounds = atoi(argv[2])) < 1)
+      rounds = 1;
+
+   tokens = readTokens(argv[1], &count);
+
+   for(r = 0; r < rounds; r++) {
+      ht = htCreate(&funcs, sizes, numSizes, 1);
+      start = clock();
+      for(i = 0; i < count; i++)
+         htAdd(ht, &tokens[i]);
+      t = seconds(start);
+      generic = (r == 0 || t < generic) ? t : generic;
+
+      wt = wtCreate(sizes, numSizes, 1);
+      start = clock();
+      for(i = 0; i < count; i++)
+         wtAdd(wt, &tokens[i]);
+      t = seconds(start);
+      specialized = (r == 0 || t < specialized) ? t : specialized;
+   }
+
+   printf("%u tokens, %u unique\n", count, wtUniqueEntries(wt));
+   printf("generic htAdd:     %8.3f s  %6.1f ns/op\n", generic,
+      generic * 1e9 / count);
+   printf("specialized wtAdd: %8.3f s  %6.1f ns/op\n", specialized,
+      specialized * 1e9 / count);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/*
+ * Sort benchmark: qsortHTEntries against parallelSortHTEntries on synthetic
+ * htToArray snapshots.
+ *
+ * Usage: bench/sortBench threads [entries...]
+ *
+ * Each size defaults to 1M, 10M and 50M entries. Words are random lowercase
+ * strings of 2 to 12 bytes and frequencies are skewed towards small values,
+ * so most comparisons fall through to compareWord like in a real run. The
+ * same seeded input is generated again for every sort and the parallel
+ * result is checked to be in compareEntry order.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hashTable.h"
+#include "getWord.h"
+#include "qsortHTEntries.h"
+#include "parallelSort.h"
+#include "myMacros.h"
+
+int compareEntry(const void *e1, const void *e2);
+
+static unsigned long state;
+
+static unsigned nextRandom(void)
+{
+   state = state * 6364136223846793005UL + 1442695040888963407UL;
+   return (unsigned)(state >> 33);
+}
+
+static void generate(HTEntry *entries, Word *words, Byte *pool,
+   unsigned count)
+{
+   unsigned i, j;
+
+   state = 42;
+   for(i = 0; i < count; i++) {
+      words[i].length = 2 + nextRandom() % 11;
+      words[i].bytes = pool + (unsigned long)i * 12;
+      words[i].borrowed = 1;
+      for(j = 0; j < words[i].length; j++)
+         words[i].bytes[j] = 'a' + nextRandom() % 26;
+      entries[i].data = &words[i];
+      entries[i].frequency = 1 + nextRandom() % (1 + nextRandom() % 1000);
+   }
+}
+
+static double now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(unsigned count, int threads)
+{
+   HTEntry *entries;
+   Word *words;
+   Byte *pool;
+   unsigned i;
+   double start, serial, parallel;
+
+   MY_MALLOC(entries, count * sizeof(HTEntry));
+   MY_MALLOC(words, count * sizeof(Word));
+   MY_MALLOC(pool, (unsigned long)count * 12);
+
+   generate(entries, words, pool, count);
+   start = now();
+   qsortHTEntries(entries, count);
+   serial = now() - start;
+
+   generate(entries, words, pool, count);
+   start = now();
+   parallelSortHTEntries(entries, count, threads);
+   parallel = now() - start;
+
+   for(i = 1; i < count; i++)
+      if(compareEntry(&entries[i - 1], &entries[i]) > 0) {
+         fprintf(stderr, "out of order at %u\n", i);
+         exit(EXIT_FAILURE);
+      }
+
+   printf("%10u entries  qsort %7.3f s  %d threads %7.3f s  x%.2f\n",
+      count, serial, threads, parallel, serial / parallel);
+
+   free(entries);
+   free(words);
+   free(pool);
+}
+
+int main(int argc, char *argv[])
+{
+   int i, threads;
+
+   if(argc < 2 || (threads = atoi(argv[1])) < 1) {
+      fprintf(stderr, "Usage: sortBench threads [entries...]\n");
+      return EXIT_FAILURE;
+   }
+
+   if(argc == 2) {
+      run(1000000, threads);
+      run(10000000, threads);
+      run(50000000, threads);
+   }
+   for(i = 2; i < argc; i++)
+      run((unsigned)atol(argv[i]), threads);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*
+ * Key order benchmark: qsort by compareWord against sortEntriesByWord, for
+ * --sort=alpha and --sort=length, on synthetic wtToArray snapshots.
+ *
+ * Usage: bench/wordSortBench [entries...]
+ *
+ * Each size defaults to 1M, 10M and 30M entries, in two vocabularies:
+ * random lowercase words of 2 to 12 bytes, and log-style identifiers
+ * ("session-" and a decimal number) that share most of their bytes. The
+ * entries are shuffled, as they come out of the hash table, the same seeded
+ * input is generated again for every sort and every result is checked.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hashTable.h"
+#include "getWord.h"
+#include "wordSort.h"
+#include "myMacros.h"
+
+#define WORD_BYTES 20
+
+static unsigned long state;
+
+static unsigned nextRandom(void)
+{
+   state = state * 6364136223846793005UL + 1442695040888963407UL;
+   return (unsigned)(state >> 33);
+}
+
+static void generate(HTEntry *entries, Word *words, Byte *pool,
+   unsigned count, int ids)
+{
+   unsigned i, j;
+   HTEntry swap;
+
+   state = 42;
+   for(i = 0; i < count; i++) {
+      words[i].bytes = pool + (unsigned long)i * WORD_BYTES;
+      words[i].borrowed = 1;
+      if(ids)
+         words[i].length = sprintf((char *)words[i].bytes, "session-%u",
+            i * 7u);
+      else {
+         words[i].length = 2 + nextRandom() % 11;
+         for(j = 0; j < words[i].length; j++)
+            words[i].bytes[j] = 'a' + nextRandom() % 26;
+      }
+      entries[i].data = &words[i];
+      entries[i].frequency = 1;
+   }
+
+   for(i = count; i > 1; i--) {
+      j = nextRandom() % i;
+      swap = entries[i - 1];
+      entries[i - 1] = entries[j];
+      entries[j] = swap;
+   }
+}
+
+static int compareAlpha(const void *e1, const void *e2)
+{
+   return compareWord(((HTEntry *)e1)->data, ((HTEntry *)e2)->data);
+}
+
+static int compareLength(const void *e1, const void *e2)
+{
+   Word *w1 = (Word *)((HTEntry *)e1)->data;
+   Word *w2 = (Word *)((HTEntry *)e2)->data;
+
+   if(w1->length != w2->length)
+      return w1->length < w2->length ? -1 : 1;
+   return compareWord(w1, w2);
+}
+
+static double now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(unsigned count, int ids, SortOrder order)
+{
+   int (*compare)(const void *, const void *) =
+      order == SORT_ALPHA ? compareAlpha : compareLength;
+   HTEntry *entries;
+   Word *words;
+   Byte *pool;
+   unsigned i;
+   double start, comparison, radix;
+
+   MY_MALLOC(entries, count * sizeof(HTEntry));
+   MY_MALLOC(words, count * sizeof(Word));
+   MY_MALLOC(pool, (unsigned long)count * WORD_BYTES);
+
+   generate(entries, words, pool, count, ids);
+   start = now();
+   qsort(entries, count, sizeof(HTEntry), compare);
+   comparison = now() - start;
+
+   generate(entries, words, pool, count, ids);
+   start = now();
+   sortEntriesByWord(entries, count, order);
+   radix = now() - start;
+
+   for(i = 1; i < count; i++)
+      if(compare(&entries[i - 1], &entries[i]) > 0) {
+         fprintf(stderr, "out of order at %u\n", i);
+         exit(EXIT_FAILURE);
+      }
+
+   printf("%10u %-6s %-6s  qsort %7.3f s  radix %7.3f s  x%.2f\n",
+      count, ids ? "ids" : "random", order == SORT_ALPHA ? "alpha" : "length",
+      comparison, radix, comparison / radix);
+
+   free(entries);
+   free(words);
+   free(pool);
+}
+
+static void runAll(unsigned count)
+{
+   run(count, 0, SORT_ALPHA);
+   run(count, 0, SORT_LENGTH);
+   run(count, 1, SORT_ALPHA);
+   run(count, 1, SORT_LENGTH);
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+
+   if(argc == 1) {
+      runAll(1000000);
+      runAll(10000000);
+      runAll(30000000);
+   }
+   for(i = 1; i < argc; i++)
+      runAll((unsigned)atol(argv[i]));
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "documents.h"
+#include "myMacros.h"
+
+/* from getWord.c */
+void *my_realloc(void *, size_t);
+
+unsigned currentDocument;
+
+/* The current document for the counts file: its name and the words counted
+ * in it so far, in the order they first occurred.
+ */
+static FILE *countsFile;
+static char *documentName;
+static DocCountWord **terms;
+static unsigned numTerms;
+static unsigned termsSize;
+
+void startDocument(const char *name, FILE *counts)
+{
+   currentDocument++;
+   countsFile = counts;
+   if(counts == NULL)
+      return;
+
+   free(documentName);
+   MY_MALLOC(documentName, strlen(name) + 1);
+   strcpy(documentName, name);
+   numTerms = 0;
+}
+
+void countInDocument(DocWord *word)
+{
+   DocCountWord *counted = (DocCountWord *)word;
+
+   if(word->lastDocument != currentDocument) {
+      word->lastDocument = currentDocument;
+      word->documents++;
+      if(countsFile == NULL)
+         return;
+
+      counted->inDocument = 0;
+      if(numTerms == termsSize) {
+         termsSize = MAX(2 * termsSize, 1024);
+         terms = my_realloc(terms, termsSize * sizeof(DocCountWord *));
+      }
+      terms[numTerms++] = counted;
+   }
+   if(countsFile != NULL)
+      counted->inDocument++;
+}
+
+void endDocument(void)
+{
+   unsigned i;
+
+   if(countsFile == NULL)
+      return;
+
+   fputs(documentName, countsFile);
+   for(i = 0; i < numTerms; i++) {
+      fprintf(countsFile, "\t%u ", terms[i]->inDocument);
+      fwrite(terms[i]->doc.word.bytes, 1, terms[i]->doc.word.length,
+         countsFile);
+   }
+   putc('\n', countsFile);
+
+   if(ferror(countsFile)) {
+      perror(NULL);
+      exit(EXIT_FAILURE);
+   }
+}
@@ -0,0 +1,64 @@
+#ifndef DOCUMENTS_H
+#define DOCUMENTS_H
+
+#include <stdio.h>
+#include "getWord.h"
+
+/* Document frequencies for --doc-freq: how many input files (documents)
+ * each word occurs in, counted in the same pass as the frequencies.
+ *
+ * No word keeps a set of its documents. Documents are numbered from 1 in
+ * the order they are read and every word of the table carries a stamp,
+ * the last document it was counted in; the first count of a word in a new
+ * document finds an older stamp, so it adds one to the word's documents and
+ * restamps it. That is eight bytes per unique word. The words are DocWords,
+ * allocated by the counter in place of Words, and the table calls
+ * countInDocument on the stored key whenever it counts one.
+ *
+ * With a counts file the words are DocCountWords instead, which also count
+ * the word inside the stamped document, eight more bytes once aligned. The
+ * words of the current document are listed as they are first stamped, and
+ * at the end of the document written to the file as one line:
+ *
+ *    name<TAB>count word<TAB>count word...
+ *
+ * in the order the words first occur. Words never hold whitespace, except
+ * the separating spaces of --ngram, so the first space of each field ends
+ * the count.
+ */
+typedef struct {
+   Word word;
+   unsigned lastDocument;
+   unsigned documents;
+} DocWord;
+
+typedef struct {
+   DocWord doc;
+   unsigned inDocument;
+} DocCountWord;
+
+/* The document being counted, 0 until the first one starts. */
+extern unsigned currentDocument;
+
+/* Description: Starts the next document. Every word counted from here on
+ *    is counted in it.
+ *
+ * Parameters:
+ *    name: Its name for the counts file, e.g. its path.
+ *    counts: Where the per document counts are written, NULL for none.
+ *       The same file must be passed for every document.
+ */
+void startDocument(const char *name, FILE *counts);
+
+/* Description: Ends the current document and writes its line to the
+ *    counts file given to startDocument, if any. Write errors are reported
+ *    with perror and the program exits.
+ */
+void endDocument(void);
+
+/* Description: Counts the word in the current document. It must be a
+ *    DocCountWord if a counts file was given to startDocument.
+ */
+void countInDocument(DocWord *word);
+
+#endif
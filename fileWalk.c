@@ -0,0 +1,206 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "fileWalk.h"
+#include "myMacros.h"
+
+/* How many files are kept open and read ahead of the one being counted.
+ */
+#define READ_AHEAD 32
+
+typedef struct {
+   int fd;
+   off_t size;
+   char *path;
+   size_t pathSize;
+} Pending;
+
+/* The window is a ring of the next READ_AHEAD files. path holds the
+ * directory being walked, with room to append entry names.
+ */
+struct FileWalk {
+   FNInputFile visit;
+   void *context;
+
+   Pending pending[READ_AHEAD];
+   unsigned first;
+   unsigned count;
+
+   char *path;
+   size_t pathLength;
+   size_t pathSize;
+};
+
+static void walkDirectory(FileWalk *walk, int fd);
+
+FileWalk *walkCreate(FNInputFile visit, void *context)
+{
+   FileWalk *walk;
+
+   MY_CALLOC(walk, 1, FileWalk);
+   walk->visit = visit;
+   walk->context = context;
+   return walk;
+}
+
+static void reportError(const char *path)
+{
+   fprintf(stderr, "wf: %s: %s\n", path, strerror(errno));
+}
+
+static void visitFirst(FileWalk *walk)
+{
+   Pending *file = &walk->pending[walk->first];
+
+   walk->first = (walk->first + 1) % READ_AHEAD;
+   walk->count--;
+   walk->visit(file->fd, file->path, file->size, walk->context);
+}
+
+static void queueFile(FileWalk *walk, int fd, off_t size)
+{
+   Pending *file;
+
+   if(walk->count == READ_AHEAD)
+      visitFirst(walk);
+
+   file = &walk->pending[(walk->first + walk->count) % READ_AHEAD];
+   if(file->pathSize < walk->pathLength + 1) {
+      free(file->path);
+      file->pathSize = MAX(walk->pathLength + 1, 2 * file->pathSize);
+      MY_MALLOC(file->path, file->pathSize);
+   }
+   memcpy(file->path, walk->path, walk->pathLength + 1);
+   file->fd = fd;
+   file->size = size;
+   walk->count++;
+
+   posix_fadvise(fd, 0, size, POSIX_FADV_WILLNEED);
+}
+
+/* Sets walk->path to the directory path with "/name" appended and returns
+ * the directory path length to restore afterwards.
+ */
+static size_t pushName(FileWalk *walk, const char *name)
+{
+   size_t saved = walk->pathLength;
+   size_t length = strlen(name);
+   char *grown;
+
+   if(walk->pathLength + length + 2 > walk->pathSize) {
+      walk->pathSize = MAX(walk->pathLength + length + 2, 2 * walk->pathSize);
+      MY_MALLOC(grown, walk->pathSize);
+      if(walk->pathLength > 0)
+         memcpy(grown, walk->path, walk->pathLength);
+      free(walk->path);
+      walk->path = grown;
+   }
+   if(walk->pathLength > 0 && walk->path[walk->pathLength - 1] != '/')
+      walk->path[walk->pathLength++] = '/';
+   memcpy(walk->path + walk->pathLength, name, length + 1);
+   walk->pathLength += length;
+   return saved;
+}
+
+/* Opens name relative to dirFd and queues or walks it. Returns -1 with errno
+ * set if it cannot be opened.
+ */
+static int walkEntry(FileWalk *walk, int dirFd, const char *name, int follow)
+{
+   int fd;
+   struct stat info;
+
+   fd = openat(dirFd, name,
+      O_RDONLY | O_NONBLOCK | (follow ? 0 : O_NOFOLLOW));
+   if(fd < 0)
+      return (errno == ELOOP && !follow) ? 0 : -1;
+
+   if(fstat(fd, &info) != 0) {
+      close(fd);
+      return -1;
+   }
+   if(S_ISREG(info.st_mode)) {
+      /* back to blocking reads for the callback */
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+      queueFile(walk, fd, info.st_size);
+   }
+   else if(S_ISDIR(info.st_mode))
+      walkDirectory(walk, fd);
+   else
+      close(fd);
+   return 0;
+}
+
+static void walkDirectory(FileWalk *walk, int fd)
+{
+   DIR *dir;
+   struct dirent *entry;
+   size_t saved;
+
+   if(NULL == (dir = fdopendir(fd))) {
+      reportError(walk->path);
+      close(fd);
+      return;
+   }
+
+   /* readdir fetches the entries in large getdents batches */
+   while(NULL != (entry = readdir(dir))) {
+      if(!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+         continue;
+      saved = pushName(walk, entry->d_name);
+      if(0 != walkEntry(walk, dirfd(dir), entry->d_name, 0))
+         reportError(walk->path);
+      walk->pathLength = saved;
+      walk->path[saved] = '\0';
+   }
+   closedir(dir);
+}
+
+int walkPath(FileWalk *walk, const char *path)
+{
+   int status;
+
+   walk->pathLength = 0;
+   pushName(walk, path);
+   status = walkEntry(walk, AT_FDCWD, path, 1);
+   return status;
+}
+
+void walkList(FileWalk *walk, FILE *list)
+{
+   char *line = NULL;
+   size_t lineSize = 0;
+   ssize_t length;
+
+   while(0 < (length = getline(&line, &lineSize, list))) {
+      if(line[length - 1] == '\n')
+         line[--length] = '\0';
+      if(length > 0 && 0 != walkPath(walk, line))
+         reportError(line);
+   }
+   free(line);
+}
+
+void walkFlush(FileWalk *walk)
+{
+   while(walk->count > 0)
+      visitFirst(walk);
+}
+
+void walkDestroy(FileWalk *walk)
+{
+   unsigned i;
+
+   walkFlush(walk);
+   for(i = 0; i < READ_AHEAD; i++)
+      free(walk->pending[i].path);
+   free(walk->path);
+   free(walk);
+}
@@ -0,0 +1,56 @@
+#ifndef FILEWALK_H
+#define FILEWALK_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+/* Feeds many input files to a callback with as few system calls as
+ * possible: directory trees are walked with openat relative to the open
+ * directory, every file is opened once and fstat'ed through the descriptor,
+ * and a window of upcoming files is kept open with posix_fadvise(WILLNEED)
+ * issued on each, so the kernel reads them ahead while earlier ones are
+ * counted.
+ *
+ * Symbolic links inside a tree are not followed and anything that is not a
+ * regular file or a directory is skipped. Entries that cannot be opened
+ * are reported on stderr and skipped.
+ */
+typedef struct FileWalk FileWalk;
+
+/* Called once per regular file, which the callback must close.
+ *
+ * Parameters:
+ *    fd: The open file, at offset 0.
+ *    path: The path for error messages, valid during the call.
+ *    size: The size fstat reported.
+ */
+typedef void (*FNInputFile)(int fd, const char *path, off_t size,
+   void *context);
+
+FileWalk *walkCreate(FNInputFile visit, void *context);
+
+/* Description: Queues a file or, recursively, every file below a directory.
+ *    Files may be handed to the callback later, at the latest by
+ *    walkDestroy.
+ *
+ * Return: 0 on success, -1 with errno set if the path itself cannot be
+ *    opened.
+ */
+int walkPath(FileWalk *walk, const char *path);
+
+/* Description: Calls walkPath for every line of the list (empty lines are
+ *    ignored). Paths that cannot be opened are reported and skipped.
+ */
+void walkList(FileWalk *walk, FILE *list);
+
+/* Description: Hands every queued file to the callback now, so input that
+ *    is read next without the walk comes after them.
+ */
+void walkFlush(FileWalk *walk);
+
+/* Description: Hands the remaining queued files to the callback and frees
+ *    the walk.
+ */
+void walkDestroy(FileWalk *walk);
+
+#endif
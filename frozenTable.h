@@ -0,0 +1,46 @@
+#ifndef FROZENTABLE_H
+#define FROZENTABLE_H
+
+#include "hashTable.h"
+
+/* Read-only tables, an addition to the hashTable.h API.
+ *
+ * While keys are added every entry is a chain node allocated on its own,
+ * so a lookup follows a bucket pointer to a node and the node to its key,
+ * and htToArray visits every node wherever it landed. Once a table is only
+ * read, htFreeze moves its entries into one array grouped by bucket, in
+ * chain order, each entry holding its data, frequency and hash, and
+ * replaces the bucket array by the index of each bucket's first entry.
+ * The nodes are then freed. An entry is the size of an HTEntry on 64 bit
+ * machines and a bucket half the size of a pointer, against a node of two
+ * pointers, a second allocation for every key counted more than seven
+ * times and the slack of the region chunks.
+ *
+ * A lookup reads the two indexes of its bucket and scans the bucket's
+ * entries, which sit next to each other, calling the compare function only
+ * on those of the same hash. htToArray copies the array in one sequential
+ * pass and returns the entries in the order it returned them before the
+ * freeze; htCapacity, htUniqueEntries, htTotalEntries and htMetrics do not
+ * change either.
+ *
+ * The keys are opaque to the table, so they stay where the caller put
+ * them. wf --serve packs its words' bytes as well, see frozenWords.h.
+ */
+
+/* Description: Compacts the hash table into its read-only layout.
+ *
+ * Notes:
+ *    1. htAdd on the table afterwards prints an error and exits, in every
+ *       build. Every other function of hashTable.h, htDestroy included,
+ *       works as before.
+ *    2. Calls the hash function once per entry. Freezing a table twice
+ *       does nothing the second time.
+ *
+ * Parameters:
+ *    hashTable: A pointer returned by htCreate.
+ *
+ * Return: None
+ */
+void htFreeze(void *hashTable);
+
+#endif
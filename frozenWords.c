@@ -0,0 +1,146 @@
+#include <string.h>
+#include <limits.h>
+#include "frozenWords.h"
+#include "wordSort.h"
+#include "myMacros.h"
+
+/* A slot of the index: the word's number plus one, 0 for an empty slot. */
+typedef struct {
+   unsigned hash;
+   unsigned word;
+} Slot;
+
+struct FrozenWords {
+   Byte *blob;
+   unsigned *offsets;      /* numWords + 1, the last one is the blob size */
+   unsigned *frequencies;
+   unsigned *ranks;        /* word numbers in the order of the entries */
+   Slot *index;
+   unsigned indexSize;
+   unsigned numWords;
+};
+
+static unsigned hashBytes(const Byte *bytes, unsigned length)
+{
+   Word word;
+
+   word.bytes = (Byte *)bytes;
+   word.length = length;
+   word.borrowed = 1;
+   return hashWord(&word);
+}
+
+#define NEXT_SLOT(WORDS, SLOT) \
+   ((SLOT) + 1 == (WORDS)->indexSize ? 0 : (SLOT) + 1)
+
+/* Fills the index, two thirds full so probe sequences stay short. The size
+ * is not rounded up to a power of two, which could nearly double it.
+ */
+static void buildIndex(FrozenWords *words)
+{
+   unsigned i, slot, hash;
+
+   words->indexSize = words->numWords + words->numWords / 2 + 1;
+   MY_CALLOC(words->index, words->indexSize, Slot);
+
+   for(i = 0; i < words->numWords; i++) {
+      hash = hashBytes(words->blob + words->offsets[i],
+         words->offsets[i + 1] - words->offsets[i]);
+      for(slot = hash % words->indexSize; words->index[slot].word != 0;
+         slot = NEXT_SLOT(words, slot))
+         ;
+      words->index[slot].hash = hash;
+      words->index[slot].word = i + 1;
+   }
+}
+
+FrozenWords *fwFreeze(HTEntry *entries, unsigned numberOfEntries)
+{
+   FrozenWords *words;
+   Word *word;
+   unsigned long size = 0;
+   unsigned i, rank, frequency;
+
+   for(i = 0; i < numberOfEntries; i++)
+      size += ((Word *)entries[i].data)->length;
+   if(size > UINT_MAX) {
+      fprintf(stderr, "wf: the words take over 4 GB, too many to serve\n");
+      exit(EXIT_FAILURE);
+   }
+
+   MY_MALLOC(words, sizeof(FrozenWords));
+   words->numWords = numberOfEntries;
+   MY_MALLOC(words->blob, size + 1);
+   MY_MALLOC(words->offsets, (numberOfEntries + 1) * sizeof(unsigned));
+   MY_MALLOC(words->frequencies, (numberOfEntries + 1) * sizeof(unsigned));
+   MY_MALLOC(words->ranks, (numberOfEntries + 1) * sizeof(unsigned));
+
+   /* sort by word in place, the frequency of each entry standing in for
+    * its rank meanwhile, and the ranks array holding the frequencies
+    */
+   for(i = 0; i < numberOfEntries; i++) {
+      words->ranks[i] = entries[i].frequency;
+      entries[i].frequency = i;
+   }
+   sortEntriesByWord(entries, numberOfEntries, SORT_ALPHA);
+
+   size = 0;
+   for(i = 0; i < numberOfEntries; i++) {
+      word = (Word *)entries[i].data;
+      rank = entries[i].frequency;
+      frequency = words->ranks[rank];
+      words->offsets[i] = size;
+      memcpy(words->blob + size, word->bytes, word->length);
+      size += word->length;
+      words->frequencies[i] = frequency;
+      words->ranks[rank] = i;
+      entries[i].frequency = frequency;
+   }
+   words->offsets[numberOfEntries] = size;
+
+   buildIndex(words);
+   return words;
+}
+
+void fwDestroy(FrozenWords *words)
+{
+   free(words->blob);
+   free(words->offsets);
+   free(words->frequencies);
+   free(words->ranks);
+   free(words->index);
+   free(words);
+}
+
+unsigned fwLookUp(const FrozenWords *words, const Byte *bytes,
+   unsigned length)
+{
+   unsigned hash = hashBytes(bytes, length);
+   unsigned slot, i;
+
+   for(slot = hash % words->indexSize; words->index[slot].word != 0;
+      slot = NEXT_SLOT(words, slot)) {
+      if(words->index[slot].hash != hash)
+         continue;
+      i = words->index[slot].word - 1;
+      if(words->offsets[i + 1] - words->offsets[i] == length
+         && 0 == memcmp(words->blob + words->offsets[i], bytes, length))
+         return words->frequencies[i];
+   }
+   return 0;
+}
+
+unsigned fwSize(const FrozenWords *words)
+{
+   return words->numWords;
+}
+
+unsigned fwRanked(const FrozenWords *words, unsigned rank,
+   const Byte **bytes, unsigned *length)
+{
+   unsigned i = words->ranks[rank];
+
+   *bytes = words->blob + words->offsets[i];
+   *length = words->offsets[i + 1] - words->offsets[i];
+   return words->frequencies[i];
+}
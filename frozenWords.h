@@ -0,0 +1,62 @@
+#ifndef FROZENWORDS_H
+#define FROZENWORDS_H
+
+#include "hashTable.h"
+#include "getWord.h"
+
+/* The counted words packed for --serve, which only reads them.
+ *
+ * The word table keeps every word in a node of its own, reached through a
+ * bucket, with the word's bytes somewhere else again. Once counting is
+ * over, fwFreeze copies the words into one blob of bytes, in compareWord
+ * order and back to back, with an offset array saying where each word
+ * starts and a parallel array of frequencies. Lookups go through an open
+ * addressing index of (hash, word number) pairs, so a GET reads one slot of
+ * the index, usually in the cache line it first touched, and then the
+ * word's offsets and bytes. TOP reads a third array, the word numbers in
+ * the order of the entries given to fwFreeze.
+ *
+ * The table the entries came from can be destroyed as soon as fwFreeze
+ * returns. Nothing can be added to a FrozenWords: there is no function for
+ * it, so a frozen table is read-only by construction.
+ */
+typedef struct FrozenWords FrozenWords;
+
+/* Description: Packs the words of the entries.
+ *
+ * Notes:
+ *    1. The entries' data are Words, all different, as returned by wtToArray
+ *       or rtToArray. The words are only read, but the entries are left
+ *       sorted by word, sorting them in place instead of a copy.
+ *    2. Exits with an error when the words do not fit in 4 GB.
+ *
+ * Parameters:
+ *    entries: The entries, in the order fwRanked should return them.
+ *    numberOfEntries: The number of entries in the array.
+ *
+ * Return: The frozen words, for fwDestroy.
+ */
+FrozenWords *fwFreeze(HTEntry *entries, unsigned numberOfEntries);
+void fwDestroy(FrozenWords *words);
+
+/* Description: The frequency of the word, 0 when it was not counted.
+ */
+unsigned fwLookUp(const FrozenWords *words, const Byte *bytes,
+   unsigned length);
+
+/* Description: The number of words.
+ */
+unsigned fwSize(const FrozenWords *words);
+
+/* Description: The word at the rank, in the order of fwFreeze's entries.
+ *
+ * Parameters:
+ *    rank: Less than fwSize.
+ *    bytes, length: Output, the word. Valid until fwDestroy.
+ *
+ * Return: The word's frequency.
+ */
+unsigned fwRanked(const FrozenWords *words, unsigned rank,
+   const Byte **bytes, unsigned *length);
+
+#endif
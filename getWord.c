@@ -1,7 +1,9 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
 #include "getWord.h"
 
 #define MIN(A,B) (((A) < (B)) ? (A):(B))
@@ -10,6 +12,9 @@ void addToWord(int, Byte **, unsigned *, int *, unsigned *);
 void *my_malloc(unsigned);
 void *my_realloc(void *, size_t);
 
+/* The stream is locked once per word instead of once per byte, as fgetc
+ * does as soon as there is a second thread (--report-every).
+ */
 int getWord(FILE *file, Byte **word, unsigned *wordLength, int *hasPrintable)
 {
    int ch;
@@ -19,12 +24,15 @@ int getWord(FILE *file, Byte **word, unsigned *wordLength, int *hasPrintable)
 
    *word = my_malloc(allocSize);
 
-   while( EOF != (ch = fgetc(file)))
+   flockfile(file);
+   while( EOF != (ch = getc_unlocked(file)))
       if(!isspace(ch))
          break;
    do{
       if(isspace(ch) || ch == EOF ) {
-         void * tmp = realloc(*word, *wordLength);
+         void * tmp;
+         funlockfile(file);
+         tmp = realloc(*word, *wordLength);
          if (NULL == tmp)
             free(tmp);
          else
@@ -34,10 +42,40 @@ int getWord(FILE *file, Byte **word, unsigned *wordLength, int *hasPrintable)
       else
          addToWord(ch, word, wordLength, hasPrintable, &allocSize);
 
-      ch = fgetc(file);
+      ch = getc_unlocked(file);
    } while(1);
 }
 
+int getWordSpan(Byte **cursor, const Byte *end, Byte **word,
+   unsigned *wordLength, int *hasPrintable, int *hasUpper)
+{
+   Byte *next = *cursor;
+
+   *hasPrintable = 0;
+   *hasUpper = 0;
+
+   while(next < end && isspace(*next))
+      next++;
+   if(next == end) {
+      *cursor = next;
+      *wordLength = 0;
+      return EOF;
+   }
+
+   *word = next;
+   for(; next < end && !isspace(*next); next++) {
+      /* Both act like latches */
+      if(isprint(*next))
+         *hasPrintable = 1;
+      if(tolower(*next) != *next)
+         *hasUpper = 1;
+   }
+
+   *wordLength = next - *word;
+   *cursor = next;
+   return 0;
+}
+
 void *my_malloc(unsigned size){
 
    void * pointer;
@@ -72,29 +110,40 @@ void addToWord(int ch, Byte ** word, unsigned *wordLength,
    (*word)[(*wordLength)++] = tolower(ch);
 }
 
-/* MODIFICATION FROM:
- *
- * https://stackoverflow.com/questions/7700400/whats-a-good-hash-function-
- * for-english-words?noredirect=1
- *
- */
-unsigned hashWord(const void * word)
-{
-   unsigned long hash = 5381;
-   Byte *startByte = ((Word *)word)->bytes;
-   int i;
+unsigned wordHashSeed = 0;
 
-   for(i = 0; i < ((Word *)word)->length; i++)
-      hash = ((hash << 5) + hash) + (*(((Word *)word)->bytes)++);
+void seedWordHash(void)
+{
+   FILE *random = fopen("/dev/urandom", "rb");
+   unsigned seed = 0;
+
+   if(random == NULL || 1 != fread(&seed, sizeof(seed), 1, random))
+      seed = (unsigned)time(NULL) ^ (unsigned)clock() * 0x9e3779b1u;
+   if(random != NULL)
+      fclose(random);
+   wordHashSeed = seed;
+}
 
-   ((Word *)word)->bytes = startByte;
+/* FNV-1a, with the seed folded into the offset basis. Unlike with djb2,
+ * which words collide then depends on the seed.
+ */
+unsigned hashWord(const void *word)
+{
+   unsigned hash = 2166136261u ^ wordHashSeed;
+   const Byte *bytes = ((const Word *)word)->bytes;
+   unsigned i;
 
+   for(i = 0; i < ((const Word *)word)->length; i++) {
+      hash ^= bytes[i];
+      hash *= 16777619u;
+   }
    return hash;
 }
 
 void destroyWord(const void *word)
 {
-   free(((Word *)word)->bytes);
+   if(!((Word *)word)->borrowed)
+      free(((Word *)word)->bytes);
 }
 
 int compareWord(const void *w1, const void *w2)
@@ -69,14 +69,44 @@
 /* Handy "new" type definition for this function */
 typedef unsigned char Byte;
 
+/* When borrowed is set the bytes belong to someone else (e.g. a mapped
+ * input file) and destroyWord leaves them alone.
+ */
 typedef struct {
    Byte *bytes;
    unsigned length;
+   int borrowed;
 } Word;
 
 /* Prototype of the function you must write */
 int getWord(FILE *file, Byte **word, unsigned *wordLength, int *hasPrintable);
 
+/*
+ * Same definition of a "word" as getWord, but for input that is already in
+ * memory (e.g. a mapped file). Nothing is copied or lowercased: the word is
+ * returned as a span of the input and hasUpper reports whether tolower would
+ * change any of its bytes.
+ *
+ * Parameters:
+ *    cursor: Where to start scanning, advanced past the word on return.
+ *    end: One past the last byte of the input.
+ *    word, wordLength: Output, the span of the word.
+ *    hasPrintable: Output, whether the word has a printable character.
+ *    hasUpper: Output, whether the word has an uppercase character.
+ *
+ * Return: 0 when a word was found, EOF when the input holds no more words.
+ */
+int getWordSpan(Byte **cursor, const Byte *end, Byte **word,
+   unsigned *wordLength, int *hasPrintable, int *hasUpper);
+
+/* The seed of hashWord (and of the word table's inlined copy of it), 0
+ * until seedWordHash sets it. Seeding keeps input from being crafted to
+ * make words collide. It must not change while any table built with the
+ * hash is in use.
+ */
+extern unsigned wordHashSeed;
+void seedWordHash(void);
+
 unsigned hashWord(const void *);
 void destroyWord(const void *);
 int compareWord(const void *, const void *);
@@ -0,0 +1,209 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "gzipReader.h"
+#include "myMacros.h"
+
+#define RING_BLOCKS 4
+#define BLOCK_SIZE (1 << 20)
+#define INPUT_SIZE (1 << 18)
+
+/* gzip header decoding on top of the default window size */
+#define GZIP_WINDOW (16 + MAX_WBITS)
+
+typedef struct {
+   Byte *bytes;
+   unsigned length;
+} Block;
+
+/* The ring: blocks [head, head + full) hold inflated data, the consumer
+ * reads the one at head until its next call, the inflate thread fills the
+ * one after the last full block.
+ */
+struct GzipReader {
+   FILE *file;
+   const char *name;
+   pthread_t thread;
+
+   pthread_mutex_t lock;
+   pthread_cond_t filled;
+   pthread_cond_t emptied;
+   Block blocks[RING_BLOCKS];
+   unsigned head;
+   unsigned full;
+   int holding;
+   int done;
+};
+
+int isGzip(FILE *file)
+{
+   int first, second;
+
+   if(EOF == (first = getc(file)))
+      return 0;
+   if(first != 0x1f) {
+      ungetc(first, file);
+      return 0;
+   }
+   if(0x8b == (second = getc(file)))
+      return 1;
+
+   /* Not gzip after all. Pipes cannot seek back; glibc takes two pushed
+    * back bytes.
+    */
+   if(0 != fseek(file, 0, SEEK_SET)) {
+      if(second != EOF)
+         ungetc(second, file);
+      ungetc(first, file);
+   }
+   return 0;
+}
+
+static void gzipFail(GzipReader *reader, const char *message)
+{
+   fprintf(stderr, "wf: %s: %s\n",
+      reader->name == NULL ? "stdin" : reader->name, message);
+   exit(EXIT_FAILURE);
+}
+
+/* Inflates into the block until it is full or the data ends. Returns 0 at
+ * the end of the data.
+ */
+static int fillBlock(GzipReader *reader, z_stream *stream, Byte *input,
+   Block *block)
+{
+   int status;
+   size_t read;
+
+   stream->next_out = block->bytes;
+   stream->avail_out = BLOCK_SIZE;
+
+   while(stream->avail_out > 0) {
+      if(stream->avail_in == 0) {
+         read = fread(input, 1, INPUT_SIZE, reader->file);
+         if(read == 0) {
+            if(ferror(reader->file))
+               gzipFail(reader, "read error");
+            if(stream->total_in != 0)
+               gzipFail(reader, "unexpected end of gzip data");
+            break;
+         }
+         stream->next_in = input;
+         stream->avail_in = read;
+      }
+
+      status = inflate(stream, Z_NO_FLUSH);
+      if(status == Z_STREAM_END)
+         inflateReset(stream);
+      else if(status != Z_OK && status != Z_BUF_ERROR)
+         gzipFail(reader, stream->msg != NULL ? stream->msg
+            : "invalid gzip data");
+   }
+
+   block->length = BLOCK_SIZE - stream->avail_out;
+   return stream->avail_out == 0;
+}
+
+static void *inflateThread(void *arg)
+{
+   GzipReader *reader = (GzipReader *)arg;
+   z_stream stream;
+   Byte *input;
+   Block *block;
+   int more = 1;
+   /* isGzip already consumed the magic bytes */
+   Byte magic[2];
+
+   magic[0] = 0x1f;
+   magic[1] = 0x8b;
+   MY_MALLOC(input, INPUT_SIZE);
+
+   stream.zalloc = Z_NULL;
+   stream.zfree = Z_NULL;
+   stream.opaque = Z_NULL;
+   stream.next_in = magic;
+   stream.avail_in = 2;
+   if(Z_OK != inflateInit2(&stream, GZIP_WINDOW))
+      gzipFail(reader, "cannot initialize zlib");
+
+   while(more) {
+      pthread_mutex_lock(&reader->lock);
+      while(reader->full == RING_BLOCKS)
+         pthread_cond_wait(&reader->emptied, &reader->lock);
+      block = &reader->blocks[(reader->head + reader->full) % RING_BLOCKS];
+      pthread_mutex_unlock(&reader->lock);
+
+      more = fillBlock(reader, &stream, input, block);
+
+      pthread_mutex_lock(&reader->lock);
+      if(block->length > 0)
+         reader->full++;
+      reader->done = !more;
+      pthread_cond_signal(&reader->filled);
+      pthread_mutex_unlock(&reader->lock);
+   }
+
+   inflateEnd(&stream);
+   free(input);
+   return NULL;
+}
+
+GzipReader *gzipOpen(FILE *file, const char *name)
+{
+   GzipReader *reader;
+   int i;
+
+   MY_CALLOC(reader, 1, GzipReader);
+   reader->file = file;
+   reader->name = name;
+   for(i = 0; i < RING_BLOCKS; i++)
+      MY_MALLOC(reader->blocks[i].bytes, BLOCK_SIZE);
+
+   pthread_mutex_init(&reader->lock, NULL);
+   pthread_cond_init(&reader->filled, NULL);
+   pthread_cond_init(&reader->emptied, NULL);
+   if(0 != pthread_create(&reader->thread, NULL, inflateThread, reader))
+      gzipFail(reader, "cannot start the inflate thread");
+   return reader;
+}
+
+Byte *gzipNextBlock(GzipReader *reader, unsigned *length)
+{
+   Block *block;
+
+   pthread_mutex_lock(&reader->lock);
+   if(reader->holding) {
+      reader->head = (reader->head + 1) % RING_BLOCKS;
+      reader->full--;
+      reader->holding = 0;
+      pthread_cond_signal(&reader->emptied);
+   }
+   while(reader->full == 0 && !reader->done)
+      pthread_cond_wait(&reader->filled, &reader->lock);
+
+   if(reader->full == 0) {
+      pthread_mutex_unlock(&reader->lock);
+      return NULL;
+   }
+   reader->holding = 1;
+   block = &reader->blocks[reader->head];
+   pthread_mutex_unlock(&reader->lock);
+
+   *length = block->length;
+   return block->bytes;
+}
+
+void gzipClose(GzipReader *reader)
+{
+   int i;
+
+   pthread_join(reader->thread, NULL);
+   pthread_mutex_destroy(&reader->lock);
+   pthread_cond_destroy(&reader->filled);
+   pthread_cond_destroy(&reader->emptied);
+   for(i = 0; i < RING_BLOCKS; i++)
+      free(reader->blocks[i].bytes);
+   free(reader);
+}
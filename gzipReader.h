@@ -0,0 +1,48 @@
+#ifndef GZIPREADER_H
+#define GZIPREADER_H
+
+#include <stdio.h>
+#include "getWord.h"
+
+/* Reads a gzip file through a ring of large blocks filled by a separate
+ * inflate thread, so decompression overlaps with counting. Concatenated
+ * gzip members (as written by "cat a.gz b.gz") are read as one stream.
+ */
+typedef struct GzipReader GzipReader;
+
+/* Description: Checks whether the file starts with the gzip magic bytes.
+ *    When it does they are consumed, ready for gzipOpen; otherwise the file
+ *    is left at its first byte.
+ *
+ * Return: 1 for gzip, otherwise 0.
+ */
+int isGzip(FILE *file);
+
+/* Description: Starts inflating a file isGzip accepted. The reader owns the
+ *    file until gzipClose, which does not close it.
+ *
+ * Parameters:
+ *    file: The input, positioned just after the magic bytes.
+ *    name: Used in error messages, NULL for stdin.
+ *
+ * Return: The new reader. Corrupt or truncated data is reported with the
+ *    file name and the program exits.
+ */
+GzipReader *gzipOpen(FILE *file, const char *name);
+
+/* Description: Hands the previous block back to the inflate thread and
+ *    waits for the next one.
+ *
+ * Parameters:
+ *    length: Output, the number of bytes in the block.
+ *
+ * Return: The block, valid until the next call, or NULL at the end of the
+ *    data.
+ */
+Byte *gzipNextBlock(GzipReader *reader, unsigned *length);
+
+/* Description: Waits for the inflate thread and frees the reader.
+ */
+void gzipClose(GzipReader *reader);
+
+#endif
@@ -1,6 +1,7 @@
 #include <limits.h>
 #include <assert.h>
 #include "hashTable.h"
+#include "frozenTable.h"
 #include "linkedList.h"
 #include "myMacros.h"
 
@@ -13,6 +14,8 @@ void assertHtCreate(unsigned *, int, float);
 void createDeepCopy(HashTable *, HTFunctions *, int, float, unsigned []);
 void metricList(ListNode *, HTMetrics *);
 void rehashTable(HashTable *);
+void destroyFrozen(HashTable *);
+HTEntry lookUpFrozen(HashTable *, void *);
 /* }}}
  */
 
@@ -152,6 +155,7 @@ void createDeepCopy(HashTable *ht, HTFunctions *functions, int numSizes,
    ht->sizeIndex = 0;
 
    MY_CALLOC(ht->actualHT, ht->sizes[ht->sizeIndex], sizeof(ListNode *));
+   ht->region = regionCreate();
 }
 
 /*
@@ -179,9 +183,15 @@ void htDestroy(void *ht)
    HashTable * pt = (HashTable *)ht;
    ListNode ** htPointer = pt->actualHT;
 
+   if(pt->frozen != NULL) {
+      destroyFrozen(pt);
+      return;
+   }
+
    for(i = 0; i < CURRENT_SIZE(pt); i++, htPointer++)
       destroyList(*htPointer, (&pt->functions)->destroy);
 
+   regionDestroy(pt->region);
    free(pt->sizes);
    free(pt->actualHT);
    free(pt);
@@ -206,6 +216,7 @@ void htDestroy(void *ht)
  *    4. When the data being added is a duplicate, the original entry is kept
  *       in the hash table AND the caller is responsible for freeing the
  *       duplicate.
+ *    5. Adding to a table frozen by htFreeze prints an error and exits.
  *
  * Parameters:
  *    hashTable: A pointer returned by htCreate.
@@ -223,6 +234,10 @@ unsigned htAdd(void *ht, void *data)
    HashTable *pt = (HashTable *)ht;
 
    assert(data != NULL);
+   if(pt->frozen != NULL) {
+      fprintf(stderr, "htAdd: the hash table is frozen, see htFreeze\n");
+      exit(EXIT_FAILURE);
+   }
 
    if(pt->rehashFactor < ((float)htUniqueEntries(pt)/(float)CURRENT_SIZE(pt))
       && ((pt->sizeIndex +1) < pt->numSizes) )
@@ -232,7 +247,7 @@ unsigned htAdd(void *ht, void *data)
    pt->totalEntries++;
 
    if( 1  == (freq = addListEntry(&(pt->actualHT[hashIndex]),
-      data, (&pt->functions)->compare)))
+      data, (&pt->functions)->compare, pt->region)))
       pt->uniqueEntries ++;
    return freq;
 }
@@ -243,8 +258,8 @@ void rehashList(ListNode *headPrev, ListNode **newArray,
    ListNode* nodePointer;
    while(headPrev != NULL){
       nodePointer = headPrev;
-      headPrev = headPrev->next;
-      addHead(&(newArray[hash(nodePointer->entry->data)%newSize]), nodePointer);
+      headPrev = NODE_NEXT(headPrev);
+      addHead(&(newArray[hash(NODE_DATA(nodePointer))%newSize]), nodePointer);
    }
 }
 
@@ -294,12 +309,16 @@ HTEntry htLookUp(void *ht, void *data)
 
    assert(data != NULL);
 
+   if(pt->frozen != NULL)
+      return lookUpFrozen(pt, data);
+
    hashIndex = (pt->functions.hash(data) % CURRENT_SIZE(pt));
    nodePointer = pt->actualHT[hashIndex];
-   if(findNode(&nodePointer, data, (&pt->functions)->compare) == 1)
-      return *(nodePointer->entry);
-   else
-      return entry;
+   if(findNode(&nodePointer, data, (&pt->functions)->compare) == 1) {
+      entry.data = NODE_DATA(nodePointer);
+      entry.frequency = NODE_FREQUENCY(nodePointer);
+   }
+   return entry;
 }
 
 /*
@@ -335,6 +354,14 @@ HTEntry* htToArray(void *ht, unsigned *size)
 
    MY_MALLOC(entryArray, htUniqueEntries(ht) * sizeof(HTEntry));
 
+   if(pt->frozen != NULL) {
+      for(; *size < htUniqueEntries(ht); (*size)++) {
+         entryArray[*size].data = pt->frozen[*size].data;
+         entryArray[*size].frequency = pt->frozen[*size].frequency;
+      }
+      return entryArray;
+   }
+
    for(i = 0; i < CURRENT_SIZE(pt); i++, htPointer++)
       addListToEntryList(entryArray, *htPointer, size);
 
@@ -429,6 +456,7 @@ unsigned htTotalEntries(void *ht)
 HTMetrics htMetrics(void *ht)
 {
    int i;
+   unsigned chainLength;
    HTMetrics metrics;
    HashTable *pt = (HashTable *)ht;
 
@@ -437,8 +465,16 @@ HTMetrics htMetrics(void *ht)
    metrics.numberOfChains = 0;
    metrics.maxChainLength = 0;
 
-   for(i = 0; i < CURRENT_SIZE(pt); i++, htPointer++)
-      metricList(*htPointer, &metrics);
+   if(pt->frozen != NULL)
+      for(i = 0; i < CURRENT_SIZE(pt); i++) {
+         chainLength = pt->starts[i + 1] - pt->starts[i];
+         if(chainLength > 0)
+            metrics.numberOfChains++;
+         metrics.maxChainLength = MAX(chainLength, metrics.maxChainLength);
+      }
+   else
+      for(i = 0; i < CURRENT_SIZE(pt); i++, htPointer++)
+         metricList(*htPointer, &metrics);
 
    metrics.avgChainLength = ((float) htUniqueEntries(ht) /
       (float) metrics.numberOfChains);
@@ -453,8 +489,82 @@ void metricList(ListNode *headPrev, HTMetrics *metrics) {
    if(headPrev != NULL)
       (metrics->numberOfChains)++;
    while(headPrev != NULL){
-      headPrev = headPrev->next;
+      headPrev = NODE_NEXT(headPrev);
       chainLength ++;
    }
    metrics->maxChainLength = MAX(chainLength, metrics->maxChainLength);
 }
+
+/*
+ * {{{ htFreeze
+ * Description: Compacts the hash table into its read-only layout, see
+ *    frozenTable.h. htAdd on the table afterwards exits with an error.
+ *
+ * Parameters:
+ *    hashTable: A pointer returned by htCreate.
+ *
+ * Return: None
+ * }}}
+ */
+void htFreeze(void *ht)
+{
+   int i;
+   unsigned size = 0;
+   HashTable *pt = (HashTable *)ht;
+   ListNode *node;
+
+   if(pt->frozen != NULL)
+      return;
+
+   /* one more than needed, so an empty table is frozen too */
+   MY_MALLOC(pt->frozen, (htUniqueEntries(ht) + 1) * sizeof(FrozenEntry));
+   MY_MALLOC(pt->starts, (CURRENT_SIZE(pt) + 1) * sizeof(unsigned));
+
+   for(i = 0; i < CURRENT_SIZE(pt); i++) {
+      pt->starts[i] = size;
+      for(node = pt->actualHT[i]; node != NULL; node = NODE_NEXT(node)) {
+         pt->frozen[size].data = NODE_DATA(node);
+         pt->frozen[size].frequency = NODE_FREQUENCY(node);
+         pt->frozen[size++].hash = pt->functions.hash(NODE_DATA(node));
+      }
+   }
+   pt->starts[i] = size;
+
+   regionDestroy(pt->region);
+   pt->region = NULL;
+   free(pt->actualHT);
+   pt->actualHT = NULL;
+}
+
+HTEntry lookUpFrozen(HashTable *pt, void *data)
+{
+   unsigned hash = pt->functions.hash(data);
+   unsigned *start = &pt->starts[hash % CURRENT_SIZE(pt)];
+   FrozenEntry *entry = &pt->frozen[start[0]];
+   FrozenEntry *end = &pt->frozen[start[1]];
+   HTEntry found;
+
+   for(; entry < end; entry++)
+      if(entry->hash == hash && !pt->functions.compare(data, entry->data))
+         break;
+
+   found.data = entry < end ? entry->data : NULL;
+   found.frequency = entry < end ? entry->frequency : 0;
+   return found;
+}
+
+void destroyFrozen(HashTable *pt)
+{
+   unsigned i;
+
+   for(i = 0; i < htUniqueEntries(pt); i++) {
+      if(pt->functions.destroy != NULL)
+         pt->functions.destroy(pt->frozen[i].data);
+      free(pt->frozen[i].data);
+   }
+
+   free(pt->frozen);
+   free(pt->starts);
+   free(pt->sizes);
+   free(pt);
+}
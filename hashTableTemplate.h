@@ -0,0 +1,1033 @@
+/* Type-specialized chained hash table "template".
+ *
+ * This file has no include guard on purpose: every inclusion generates one
+ * table type and its functions, all named with the TT_PREFIX given by the
+ * includer. The behavior mirrors the generic table in hashTable.h (same
+ * sizes list, rehash rule, duplicate handling and HTEntry results) but the
+ * hash, compare and destroy operations are expanded in place instead of
+ * being called through HTFunctions, so the compiler can inline them.
+ *
+ * Before including this file define:
+ *
+ *    TT_PREFIX            Prefix for every generated name, e.g. wt gives
+ *                         wtTable, wtCreate, wtAdd...
+ *    TT_KEY               The key type. Keys are stored by pointer; who
+ *                         frees them is chosen below. Every key must be
+ *                         aligned to REGION_ALIGNMENT, as memory from
+ *                         malloc or Allocate is, see Structures.
+ *
+ * In the one translation unit that instantiates the code also define:
+ *
+ *    TT_IMPLEMENTATION
+ *    TT_HASH(key)         Expression giving the unsigned hash of a TT_KEY *.
+ *    TT_COMPARE(k1, k2)   Expression comparing two TT_KEY *, zero if equal.
+ *
+ * and exactly one of:
+ *
+ *    TT_DESTROY(key)      Statement freeing a key's sub-allocations (but not
+ *                         the key itself), may expand to nothing. Destroy
+ *                         calls it and frees each key, like htDestroy.
+ *    TT_KEYS_IN_REGION    Keys and whatever they point to are allocated with
+ *                         Allocate/AllocateBytes (or owned elsewhere), so
+ *                         Destroy never visits them.
+ *
+ * and optionally:
+ *
+ *    TT_COUNTED(key)      Statement run with the stored TT_KEY * every time
+ *                         an add counts it, new or not.
+ *
+ * Optionally:
+ *
+ *    TT_CACHE_BITS        log2 of the number of front cache slots (default
+ *                         10), 0 for no front cache. See Structures.
+ *    TT_TREEIFY           Chains found longer than this (default 8) are
+ *                         indexed by a balanced tree. See Structures.
+ *    TT_SNAPSHOTS         Adds Snapshot, Quiesce, Online and Offline, for
+ *                         reading point-in-time snapshots from another
+ *                         thread while keys are being added. Needs pthreads
+ *                         and GCC's __sync_synchronize. See Snapshots.
+ *
+ * Entries always live in a region owned by the table. With TT_KEYS_IN_REGION
+ * destroying a table frees a handful of chunks no matter how many words it
+ * holds.
+ *
+ * All of the above are undefined again at the end of this file.
+ */
+
+#include "hashTable.h"
+#include "region.h"
+
+#define TT_CAT2(A,B) A##B
+#define TT_CAT(A,B) TT_CAT2(A,B)
+#define TT_NAME(NAME) TT_CAT(TT_PREFIX,NAME)
+#define TT_TABLE TT_NAME(Table)
+#define TT_NODE TT_NAME(Node)
+
+typedef struct TT_TABLE TT_TABLE;
+
+#ifndef TT_METRICS_DEFINED
+#define TT_METRICS_DEFINED
+/* Returned by Metrics: the chain metrics of htMetrics plus the front cache,
+ * the trees and the rehashes. cacheHitRate is the share of adds that were
+ * served by the cache, treeConversions counts the chains turned into trees
+ * so far (a rehash drops the trees, so a chain may be counted more than
+ * once) and rehashes the times an add grew the table.
+ */
+typedef struct {
+   HTMetrics chains;
+   unsigned cacheSlots;
+   unsigned cacheHits;
+   float cacheHitRate;
+   unsigned treeConversions;
+   unsigned rehashes;
+} TTMetrics;
+#endif
+
+/* Same contracts as htCreate, htDestroy, htAdd, htLookUp, htToArray,
+ * htCapacity, htUniqueEntries, htTotalEntries and htMetrics. The data in
+ * every returned HTEntry is a TT_KEY *.
+ */
+TT_TABLE *TT_NAME(Create)(unsigned sizes[], int numSizes,
+   float rehashLoadFactor);
+void TT_NAME(Destroy)(TT_TABLE *table);
+unsigned TT_NAME(Add)(TT_TABLE *table, TT_KEY *key);
+HTEntry TT_NAME(LookUp)(TT_TABLE *table, TT_KEY *key);
+HTEntry *TT_NAME(ToArray)(TT_TABLE *table, unsigned *size);
+unsigned TT_NAME(Capacity)(TT_TABLE *table);
+unsigned TT_NAME(UniqueEntries)(TT_TABLE *table);
+unsigned TT_NAME(TotalEntries)(TT_TABLE *table);
+TTMetrics TT_NAME(Metrics)(TT_TABLE *table);
+
+/* Add and LookUp with the hash computed by the caller instead of TT_HASH,
+ * for keys whose hash is cheaper to derive from their parts. Every key of
+ * such a table must be added and looked up this way.
+ */
+unsigned TT_NAME(AddHashed)(TT_TABLE *table, TT_KEY *key, unsigned hash);
+HTEntry TT_NAME(LookUpHashed)(TT_TABLE *table, TT_KEY *key, unsigned hash);
+
+/* Adds the n keys in order, exactly like n calls to Add, and stores the
+ * frequency each call would have returned in freqs. The batch is hashed and
+ * its bucket slots and chain heads are prefetched before any chain is
+ * walked, so the cache misses of the whole batch overlap instead of each
+ * Add stalling on its own. Within a batch, a key may equal an earlier one.
+ */
+void TT_NAME(AddBatch)(TT_TABLE *table, TT_KEY *keys[], unsigned n,
+   unsigned freqs[]);
+
+/* Grows the table, if needed, to the first size that holds expected unique
+ * keys without a rehash, so a table sized up front skips the rehashes on
+ * the way there. Never shrinks it; adds keep growing it past expected.
+ */
+void TT_NAME(Reserve)(TT_TABLE *table, unsigned expected);
+
+/* Memory that stays valid until the table is destroyed and is then freed
+ * with it. Allocate is aligned for any type, AllocateBytes is not. The
+ * caller counts it with memCount for --mem-report.
+ */
+void *TT_NAME(Allocate)(TT_TABLE *table, size_t size);
+void *TT_NAME(AllocateBytes)(TT_TABLE *table, size_t size);
+
+#ifdef TT_SNAPSHOTS
+/* Called by a thread other than the one adding: waits for the adding
+ * thread to take a snapshot and returns the entries as they were then
+ * (unordered, uniqueEntries of them in *size) and their total frequency in
+ * *totalEntries. Only one snapshot is read at a time, a second caller
+ * waits for the first. The caller frees the array.
+ */
+HTEntry *TT_NAME(Snapshot)(TT_TABLE *table, unsigned *size,
+   unsigned *totalEntries);
+
+/* Called by the adding thread between adds: a snapshot requested since the
+ * last call is taken here, at this point of the adds. Costs one load when
+ * there is nothing to do.
+ */
+void TT_NAME(Quiesce)(TT_TABLE *table);
+
+/* Online tells the table that the calling thread is about to add keys and
+ * will call Quiesce every so often; Offline that it has stopped and will
+ * not until it calls Online again. While offline, which is how a table
+ * starts out, Snapshot does not wait for Quiesce.
+ */
+void TT_NAME(Online)(TT_TABLE *table);
+void TT_NAME(Offline)(TT_TABLE *table);
+#endif
+
+#ifdef TT_IMPLEMENTATION
+
+#include <assert.h>
+#include "hugePages.h"
+#include "myMacros.h"
+
+#ifndef TT_PREFETCH
+#ifdef __GNUC__
+#define TT_PREFETCH(ADDRESS) __builtin_prefetch(ADDRESS)
+#else
+#define TT_PREFETCH(ADDRESS) ((void)0)
+#endif
+#endif
+
+/* AddBatch works through its keys this many at a time. */
+#define TT_BATCH 64
+
+#ifndef TT_CACHE_BITS
+#define TT_CACHE_BITS 10
+#endif
+
+/* A cache slot's confidence in its node is capped here, so a node that has
+ * gone cold loses the slot after at most this many adds of other keys.
+ */
+#define TT_CACHE_CONFIDENCE 8
+
+#ifndef TT_TREEIFY
+#define TT_TREEIFY 8
+#endif
+
+#ifdef TT_SNAPSHOTS
+#include <limits.h>
+#include <pthread.h>
+
+#ifndef __GNUC__
+#error "TT_SNAPSHOTS needs __sync_synchronize"
+#endif
+#define TT_BARRIER() __sync_synchronize()
+
+/* The life of a snapshot: asked for by the reader, taken by the adding
+ * thread, read, and released by the reader for the adding thread to end.
+ */
+#define TT_IDLE 0
+#define TT_REQUESTED 1
+#define TT_READING 2
+#define TT_RELEASED 3
+
+/* The buckets and chains must stay as they are while a snapshot is read. */
+#define TT_FROZEN(TABLE) ((TABLE)->logStart != 0)
+#else
+#define TT_FROZEN(TABLE) 0
+#endif
+
+/*
+ * {{{ Structures -
+ *
+ * One region allocation per entry: the node holds the key, the chain link
+ * and the cached hash, so rehashing never calls TT_HASH again and most
+ * chain mismatches are rejected without TT_COMPARE.
+ *
+ * Most keys of a large vocabulary are counted once or twice, so the node
+ * has no frequency field. Keys are aligned like region memory and the key
+ * pointer carries the frequency as its region tag (see region.h), up to
+ * REGION_TAG_MAX: 7 with 8 byte pointers. The add that outgrows the tag
+ * allocates a wide counter, an HTEntry holding the key and its full
+ * frequency, from the region, and points the node at it with tag 0. The key
+ * never moves, so cache slots and snapshot readers find it either way.
+ *
+ * In front of the buckets sits a small direct-mapped cache, picked by the
+ * top bits of the hash, whose slots point straight at a node and its key.
+ * In natural text a few hundred words make up half of all adds; once one
+ * of them owns its slot, adding it again is one compare and one increment,
+ * without the modulo, the bucket array or the chain. Nodes never move, not
+ * even on a rehash, so the slots stay valid for the life of the table.
+ *
+ * A slot is won by the first key that maps to it. Each hit raises the
+ * slot's confidence, up to TT_CACHE_CONFIDENCE, and each add of another key
+ * mapping there lowers it; at zero that key takes the slot over. Keys that
+ * keep coming back hold on to their slot, and the cache follows the hot set
+ * as it shifts through the input.
+ *
+ * Chains are unbounded lists, so keys that collide, by accident of the
+ * input or by design, would make every add a linear scan. When an add or
+ * lookup walks more than TT_TREEIFY nodes of a chain, the bucket is indexed
+ * by an AVL tree of its nodes, ordered by hash and then TT_COMPARE, and from
+ * then on searched in logarithmic time. The chain itself stays complete, so
+ * nothing that only iterates the table needs to know about trees. The roots
+ * live in a second bucket array that is only allocated on the first
+ * conversion. A rehash drops all trees and lets long chains convert again
+ * when next walked; their tree nodes go to a free list for reuse.
+ * }}}
+ */
+typedef struct TT_NODE {
+   void *counted;          /* the tagged key or its wide counter */
+   struct TT_NODE *next;
+   unsigned hash;
+#ifdef TT_SNAPSHOTS
+   unsigned version;
+#endif
+} TT_NODE;
+
+#if TT_CACHE_BITS > 0
+typedef struct {
+   TT_KEY *key;
+   TT_NODE *node;
+   unsigned hash;
+   unsigned confidence;
+} TT_NAME(CacheSlot);
+
+#define TT_CACHE_SLOT(HASH) \
+   ((((HASH) * 0x9e3779b1u) & 0xffffffffu) >> (32 - TT_CACHE_BITS))
+#endif
+
+#define TT_TREE TT_NAME(Tree)
+
+typedef struct TT_TREE {
+   TT_NODE *node;
+   struct TT_TREE *child[2];
+   int height;
+} TT_TREE;
+
+struct TT_TABLE {
+   unsigned *sizes;
+   int numSizes;
+   float rehashFactor;
+
+   int sizeIndex;
+   TT_NODE **buckets;
+   unsigned totalEntries;
+   unsigned uniqueEntries;
+
+   Region *region;
+
+   TT_TREE **trees;
+   TT_TREE *freeTrees;
+   unsigned treeConversions;
+   unsigned rehashes;
+
+#if TT_CACHE_BITS > 0
+   TT_NAME(CacheSlot) *cache;
+   unsigned cacheHits;
+#endif
+
+#ifdef TT_SNAPSHOTS
+   pthread_mutex_t snapshotLock;
+   pthread_cond_t snapshotChanged;
+   int snapshotState;
+   int online;
+   volatile int snapshotPending;  /* Quiesce has work to do */
+
+   unsigned *log;
+   unsigned logStart;
+   unsigned logSize;
+   unsigned logUsed;
+   unsigned nextLogStart;
+
+   TT_NODE **snapshotBuckets;
+   unsigned snapshotSize;
+   unsigned snapshotUnique;
+   unsigned snapshotTotal;
+#endif
+};
+
+#define TT_NARROW(NODE) REGION_TAG((NODE)->counted)
+#define TT_WIDE(NODE) ((HTEntry *)(NODE)->counted)
+#define TT_KEY_OF(NODE) ((TT_KEY *)(TT_NARROW(NODE) \
+   ? REGION_UNTAG((NODE)->counted) : TT_WIDE(NODE)->data))
+#define TT_FREQUENCY(NODE) \
+   (TT_NARROW(NODE) ? TT_NARROW(NODE) : TT_WIDE(NODE)->frequency)
+
+/* The key and frequency of a node's counted field, read once. */
+static HTEntry TT_NAME(EntryOf)(void *counted)
+{
+   HTEntry entry;
+
+   if(REGION_TAG(counted) == 0)
+      return *(HTEntry *)counted;
+   entry.data = REGION_UNTAG(counted);
+   entry.frequency = REGION_TAG(counted);
+   return entry;
+}
+
+TT_TABLE *TT_NAME(Create)(unsigned sizes[], int numSizes,
+   float rehashLoadFactor)
+{
+   int i;
+   TT_TABLE *table;
+
+   assert(numSizes > 0);
+   assert(sizes[0] > 0);
+   for(i = 1; i < numSizes; i++)
+      assert(sizes[i-1] < sizes[i]);
+   assert(0.0 < rehashLoadFactor && rehashLoadFactor <= 1.0);
+
+   MY_CALLOC(table, 1, TT_TABLE);
+   MY_MALLOC(table->sizes, numSizes * sizeof(unsigned));
+   for(i = 0; i < numSizes; i++)
+      table->sizes[i] = sizes[i];
+   table->numSizes = numSizes;
+   table->rehashFactor = rehashLoadFactor;
+
+   table->buckets = hugeAlloc(table->sizes[0] * sizeof(TT_NODE *), 1,
+      MEM_BUCKETS);
+#if TT_CACHE_BITS > 0
+   MY_CALLOC_COUNTED(table->cache, 1 << TT_CACHE_BITS, TT_NAME(CacheSlot),
+      MEM_CACHE);
+#endif
+   table->region = regionCreate();
+#ifdef TT_SNAPSHOTS
+   pthread_mutex_init(&table->snapshotLock, NULL);
+   pthread_cond_init(&table->snapshotChanged, NULL);
+   table->nextLogStart = 1;
+#endif
+   return table;
+}
+
+void TT_NAME(Destroy)(TT_TABLE *table)
+{
+#ifndef TT_KEYS_IN_REGION
+   unsigned i;
+   TT_NODE *node;
+
+   for(i = 0; i < CURRENT_SIZE(table); i++)
+      for(node = table->buckets[i]; node != NULL; node = node->next) {
+         TT_DESTROY(TT_KEY_OF(node));
+         free(TT_KEY_OF(node));
+      }
+#endif
+
+#ifdef TT_SNAPSHOTS
+   assert(table->snapshotState == TT_IDLE);
+   pthread_mutex_destroy(&table->snapshotLock);
+   pthread_cond_destroy(&table->snapshotChanged);
+#endif
+
+   regionDestroy(table->region);
+#if TT_CACHE_BITS > 0
+   free(table->cache);
+#endif
+   hugeFree(table->trees, CURRENT_SIZE(table) * sizeof(TT_TREE *),
+      MEM_TREES);
+   hugeFree(table->buckets, CURRENT_SIZE(table) * sizeof(TT_NODE *),
+      MEM_BUCKETS);
+   free(table->sizes);
+   free(table);
+}
+
+/* {{{ Trees - AVL trees over the nodes of long chains, see Structures.
+ *
+ * Nodes are only ever added, so insertion is all the balancing needed.
+ */
+
+/* Where key sorts relative to node: negative, zero or positive. */
+static int TT_NAME(TreeOrder)(TT_NODE *node, TT_KEY *key, unsigned hash)
+{
+   if(hash != node->hash)
+      return hash < node->hash ? -1 : 1;
+   return TT_COMPARE(key, TT_KEY_OF(node));
+}
+
+static TT_NODE *TT_NAME(TreeFind)(TT_TREE *tree, TT_KEY *key, unsigned hash)
+{
+   int order;
+
+   while(tree != NULL) {
+      if(0 == (order = TT_NAME(TreeOrder)(tree->node, key, hash)))
+         return tree->node;
+      tree = tree->child[order > 0];
+   }
+   return NULL;
+}
+
+static int TT_NAME(TreeHeight)(TT_TREE *tree)
+{
+   return tree == NULL ? 0 : tree->height;
+}
+
+static void TT_NAME(TreeUpdate)(TT_TREE *tree)
+{
+   tree->height = 1 + MAX(TT_NAME(TreeHeight)(tree->child[0]),
+      TT_NAME(TreeHeight)(tree->child[1]));
+}
+
+/* Lifts the child on the given side (0 left, 1 right) above tree. */
+static TT_TREE *TT_NAME(TreeRotate)(TT_TREE *tree, int side)
+{
+   TT_TREE *up = tree->child[side];
+
+   tree->child[side] = up->child[!side];
+   up->child[!side] = tree;
+   TT_NAME(TreeUpdate)(tree);
+   TT_NAME(TreeUpdate)(up);
+   return up;
+}
+
+static TT_TREE *TT_NAME(TreeBalance)(TT_TREE *tree)
+{
+   int side, skew;
+
+   TT_NAME(TreeUpdate)(tree);
+   skew = TT_NAME(TreeHeight)(tree->child[1])
+      - TT_NAME(TreeHeight)(tree->child[0]);
+   if(skew < -1 || skew > 1) {
+      side = skew > 0;
+      if(TT_NAME(TreeHeight)(tree->child[side]->child[!side])
+         > TT_NAME(TreeHeight)(tree->child[side]->child[side]))
+         tree->child[side] = TT_NAME(TreeRotate)(tree->child[side], !side);
+      tree = TT_NAME(TreeRotate)(tree, side);
+   }
+   return tree;
+}
+
+/* Inserts a node whose key is not in the tree yet, returns the new root. */
+static TT_TREE *TT_NAME(TreeInsert)(TT_TABLE *table, TT_TREE *tree,
+   TT_NODE *node)
+{
+   int side;
+
+   if(tree == NULL) {
+      if(NULL != (tree = table->freeTrees))
+         table->freeTrees = tree->child[0];
+      else {
+         tree = regionAlloc(table->region, sizeof(TT_TREE));
+         memCount(MEM_TREES, sizeof(TT_TREE));
+      }
+      tree->node = node;
+      tree->child[0] = tree->child[1] = NULL;
+      tree->height = 1;
+      return tree;
+   }
+
+   side = TT_NAME(TreeOrder)(tree->node, TT_KEY_OF(node), node->hash) > 0;
+   tree->child[side] = TT_NAME(TreeInsert)(table, tree->child[side], node);
+   return TT_NAME(TreeBalance)(tree);
+}
+
+static void TT_NAME(TreeRelease)(TT_TABLE *table, TT_TREE *tree)
+{
+   if(tree == NULL)
+      return;
+   TT_NAME(TreeRelease)(table, tree->child[0]);
+   TT_NAME(TreeRelease)(table, tree->child[1]);
+   tree->child[0] = table->freeTrees;
+   table->freeTrees = tree;
+}
+
+static void TT_NAME(Treeify)(TT_TABLE *table, unsigned bucket)
+{
+   TT_NODE *node;
+
+   if(table->trees == NULL)
+      table->trees = hugeAlloc(CURRENT_SIZE(table) * sizeof(TT_TREE *), 1,
+         MEM_TREES);
+
+   for(node = table->buckets[bucket]; node != NULL; node = node->next)
+      table->trees[bucket] = TT_NAME(TreeInsert)(table,
+         table->trees[bucket], node);
+   table->treeConversions++;
+}
+
+/* }}} */
+
+/* Moves every node to a bucket array of the given size index. */
+static void TT_NAME(Resize)(TT_TABLE *table, int sizeIndex)
+{
+   unsigned i;
+   unsigned nextSize = table->sizes[sizeIndex];
+   TT_NODE **newBuckets;
+   TT_NODE *node, *next;
+
+   if(table->trees != NULL) {
+      for(i = 0; i < CURRENT_SIZE(table); i++)
+         TT_NAME(TreeRelease)(table, table->trees[i]);
+      hugeFree(table->trees, CURRENT_SIZE(table) * sizeof(TT_TREE *),
+         MEM_TREES);
+      table->trees = NULL;
+   }
+
+   newBuckets = hugeAlloc(nextSize * sizeof(TT_NODE *), 1, MEM_BUCKETS);
+
+   for(i = 0; i < CURRENT_SIZE(table); i++)
+      for(node = table->buckets[i]; node != NULL; node = next) {
+         next = node->next;
+         node->next = newBuckets[node->hash % nextSize];
+         newBuckets[node->hash % nextSize] = node;
+      }
+
+   hugeFree(table->buckets, CURRENT_SIZE(table) * sizeof(TT_NODE *),
+      MEM_BUCKETS);
+   table->buckets = newBuckets;
+   table->sizeIndex = sizeIndex;
+}
+
+static void TT_NAME(Rehash)(TT_TABLE *table)
+{
+   TT_NAME(Resize)(table, table->sizeIndex + 1);
+   table->rehashes++;
+}
+
+void TT_NAME(Reserve)(TT_TABLE *table, unsigned expected)
+{
+   int i = table->sizeIndex;
+
+   assert(!TT_FROZEN(table));
+   while(i + 1 < table->numSizes
+      && table->rehashFactor * table->sizes[i] < (float)expected)
+      i++;
+   if(i > table->sizeIndex)
+      TT_NAME(Resize)(table, i);
+}
+
+/* Returns the key's node, or NULL after setting *link to where a new node
+ * goes: the NULL link at the end of the chain, or the bucket itself when
+ * the bucket has a tree. Converts the chain when it was too long.
+ */
+static TT_NODE *TT_NAME(Find)(TT_TABLE *table, TT_KEY *key, unsigned hash,
+   TT_NODE ***link)
+{
+   unsigned bucket = hash % CURRENT_SIZE(table);
+   unsigned steps = 0;
+
+   *link = &table->buckets[bucket];
+   if(table->trees != NULL && table->trees[bucket] != NULL)
+      return TT_NAME(TreeFind)(table->trees[bucket], key, hash);
+
+   while(**link != NULL && ((**link)->hash != hash
+      || TT_COMPARE(TT_KEY_OF(**link), key) != 0)) {
+      *link = &(**link)->next;
+      steps++;
+   }
+
+   if(steps > TT_TREEIFY)
+      TT_NAME(Treeify)(table, bucket);
+   return **link;
+}
+
+#if TT_CACHE_BITS > 0
+/* Called with the node of every add the cache missed. */
+static void TT_NAME(CacheMiss)(TT_NAME(CacheSlot) *slot, TT_NODE *node)
+{
+   if(slot->confidence > 0 && --slot->confidence > 0)
+      return;
+   slot->key = TT_KEY_OF(node);
+   slot->node = node;
+   slot->hash = node->hash;
+   slot->confidence = 1;
+}
+#endif
+
+/* Adds one to the frequency of a node already counted, moving it to a wide
+ * counter when it outgrows the tag. While a snapshot is read, the node's
+ * frequency is logged for it first, the first time it changes.
+ */
+static unsigned TT_NAME(Count)(TT_TABLE *table, TT_NODE *node)
+{
+   HTEntry *wide;
+   unsigned count = TT_NARROW(node);
+
+#ifdef TT_SNAPSHOTS
+   if(node->version < table->logStart) {
+      table->log[table->logUsed] = TT_FREQUENCY(node);
+      TT_BARRIER();
+      node->version = table->logStart + table->logUsed++;
+      TT_BARRIER();
+   }
+#endif
+#ifdef TT_COUNTED
+   TT_COUNTED(TT_KEY_OF(node));
+#endif
+
+   if(count == 0)
+      return ++TT_WIDE(node)->frequency;
+   if(count < REGION_TAG_MAX) {
+      node->counted = REGION_TAGGED(REGION_UNTAG(node->counted), count + 1);
+      return count + 1;
+   }
+
+   wide = regionAlloc(table->region, sizeof(HTEntry));
+   memCount(MEM_NODES, sizeof(HTEntry));
+   wide->data = REGION_UNTAG(node->counted);
+   wide->frequency = count + 1;
+#ifdef TT_SNAPSHOTS
+   TT_BARRIER();
+#endif
+   node->counted = wide;
+   return count + 1;
+}
+
+unsigned TT_NAME(AddHashed)(TT_TABLE *table, TT_KEY *key, unsigned hash)
+{
+   TT_NODE **link, *node;
+   unsigned bucket;
+#if TT_CACHE_BITS > 0
+   TT_NAME(CacheSlot) *slot = &table->cache[TT_CACHE_SLOT(hash)];
+#endif
+
+   assert(key != NULL);
+   assert(REGION_TAG(key) == 0);
+
+#if TT_CACHE_BITS > 0
+   if(slot->hash == hash && slot->key != NULL
+      && TT_COMPARE(slot->key, key) == 0) {
+      if(slot->confidence < TT_CACHE_CONFIDENCE)
+         slot->confidence++;
+      table->cacheHits++;
+      table->totalEntries++;
+      return TT_NAME(Count)(table, slot->node);
+   }
+#endif
+
+   if(table->rehashFactor <
+      ((float)table->uniqueEntries / (float)CURRENT_SIZE(table))
+      && (table->sizeIndex + 1) < table->numSizes && !TT_FROZEN(table))
+      TT_NAME(Rehash)(table);
+
+   table->totalEntries++;
+
+   if(NULL == (node = TT_NAME(Find)(table, key, hash, &link))) {
+      node = regionAlloc(table->region, sizeof(TT_NODE));
+      memCount(MEM_NODES, sizeof(TT_NODE));
+      node->counted = REGION_TAGGED(key, 1);
+      node->hash = hash;
+      node->next = *link;
+#ifdef TT_SNAPSHOTS
+      /* not part of the snapshot being read, if any */
+      node->version = TT_FROZEN(table) ? table->logStart + table->logSize
+         : 0;
+      TT_BARRIER();
+#endif
+      *link = node;
+      table->uniqueEntries++;
+
+      bucket = hash % CURRENT_SIZE(table);
+      if(table->trees != NULL && table->trees[bucket] != NULL)
+         table->trees[bucket] = TT_NAME(TreeInsert)(table,
+            table->trees[bucket], node);
+
+#if TT_CACHE_BITS > 0
+      TT_NAME(CacheMiss)(slot, node);
+#endif
+#ifdef TT_COUNTED
+      TT_COUNTED(key);
+#endif
+      return 1;
+   }
+
+#if TT_CACHE_BITS > 0
+   TT_NAME(CacheMiss)(slot, node);
+#endif
+   return TT_NAME(Count)(table, node);
+}
+
+unsigned TT_NAME(Add)(TT_TABLE *table, TT_KEY *key)
+{
+   assert(key != NULL);
+   return TT_NAME(AddHashed)(table, key, TT_HASH(key));
+}
+
+void TT_NAME(AddBatch)(TT_TABLE *table, TT_KEY *keys[], unsigned n,
+   unsigned freqs[])
+{
+   unsigned hashes[TT_BATCH];
+   unsigned i, count;
+   TT_NODE *head;
+
+   for(; n > 0; keys += count, freqs += count, n -= count) {
+      count = MIN(n, TT_BATCH);
+
+      /* the bucket slots... */
+      for(i = 0; i < count; i++) {
+         hashes[i] = TT_HASH(keys[i]);
+         TT_PREFETCH(&table->buckets[hashes[i] % CURRENT_SIZE(table)]);
+      }
+      /* ...then the first node of each chain, once its slot has arrived */
+      for(i = 0; i < count; i++)
+         if(NULL != (head = table->buckets[hashes[i] % CURRENT_SIZE(table)]))
+            TT_PREFETCH(head);
+
+      /* A rehash in here only makes some prefetches useless, AddHashed
+       * finds the buckets again.
+       */
+      for(i = 0; i < count; i++)
+         freqs[i] = TT_NAME(AddHashed)(table, keys[i], hashes[i]);
+   }
+}
+
+HTEntry TT_NAME(LookUpHashed)(TT_TABLE *table, TT_KEY *key, unsigned hash)
+{
+   TT_NODE **link, *node;
+   HTEntry entry;
+
+   assert(key != NULL);
+
+   if(NULL != (node = TT_NAME(Find)(table, key, hash, &link)))
+      return TT_NAME(EntryOf)(node->counted);
+
+   entry.data = NULL;
+   entry.frequency = 0;
+   return entry;
+}
+
+HTEntry TT_NAME(LookUp)(TT_TABLE *table, TT_KEY *key)
+{
+   assert(key != NULL);
+   return TT_NAME(LookUpHashed)(table, key, TT_HASH(key));
+}
+
+HTEntry *TT_NAME(ToArray)(TT_TABLE *table, unsigned *size)
+{
+   unsigned i;
+   TT_NODE *node;
+   HTEntry *entryArray;
+
+   *size = 0;
+   if(table->uniqueEntries == 0)
+      return NULL;
+
+   MY_MALLOC_COUNTED(entryArray, table->uniqueEntries * sizeof(HTEntry),
+      MEM_RESULTS);
+
+   for(i = 0; i < CURRENT_SIZE(table); i++)
+      for(node = table->buckets[i]; node != NULL; node = node->next)
+         entryArray[(*size)++] = TT_NAME(EntryOf)(node->counted);
+
+   return entryArray;
+}
+
+#ifdef TT_SNAPSHOTS
+/* {{{ Snapshots -
+ *
+ * A snapshot is taken by the adding thread in Quiesce, between two adds,
+ * and read by another thread while adds go on. Taking it copies nothing: it
+ * records the bucket array and opens a log, and reading it walks the live
+ * chains. Every node carries a version. The first time a node's frequency
+ * changes while a snapshot is read, the old frequency is appended to the
+ * log and the node's version set to logStart plus its log index, so the
+ * reader takes frequencies from nodes it finds unchanged and from the log
+ * for the others. Nodes added meanwhile get the version just past the log
+ * and are skipped. Reading a node costs two barriers, adding to a node that
+ * is already logged or when there is no snapshot costs one compare.
+ *
+ * Versions of different snapshots never overlap (each one starts past the
+ * last one's log) so nothing has to be reset in between; only when they
+ * are about to wrap around are all nodes set back to 0.
+ *
+ * Rehashing would relink the chains under the reader, so it waits until the
+ * snapshot is released, as does the log's free; the next Quiesce ends the
+ * snapshot and the next add grows the table if it is due. Nodes, trees and
+ * keys are never freed before the table, so nothing else needs to wait.
+ *
+ * The log and the array a snapshot returns are not counted for
+ * --mem-report; the reader allocates in its own thread.
+ * }}}
+ */
+
+/* Takes the snapshot, with the lock held and no add in progress. */
+static void TT_NAME(BeginSnapshot)(TT_TABLE *table)
+{
+   unsigned i;
+   TT_NODE *node;
+
+   if(table->nextLogStart > UINT_MAX - table->uniqueEntries - 1) {
+      for(i = 0; i < CURRENT_SIZE(table); i++)
+         for(node = table->buckets[i]; node != NULL; node = node->next)
+            node->version = 0;
+      table->nextLogStart = 1;
+   }
+
+   table->logSize = table->uniqueEntries;
+   MY_MALLOC(table->log, (table->logSize + 1) * sizeof(unsigned));
+   table->logUsed = 0;
+   table->logStart = table->nextLogStart;
+   table->nextLogStart += table->logSize + 1;
+
+   table->snapshotBuckets = table->buckets;
+   table->snapshotSize = CURRENT_SIZE(table);
+   table->snapshotUnique = table->uniqueEntries;
+   table->snapshotTotal = table->totalEntries;
+   table->snapshotState = TT_READING;
+}
+
+/* Moves a requested snapshot to READING, a released one to IDLE, with the
+ * lock held and no add in progress.
+ */
+static void TT_NAME(AdvanceSnapshot)(TT_TABLE *table)
+{
+   if(table->snapshotState == TT_REQUESTED)
+      TT_NAME(BeginSnapshot)(table);
+   else if(table->snapshotState == TT_RELEASED) {
+      free(table->log);
+      table->log = NULL;
+      table->logStart = 0;
+      table->snapshotState = TT_IDLE;
+   }
+   else
+      return;
+   table->snapshotPending = 0;
+   pthread_cond_broadcast(&table->snapshotChanged);
+}
+
+/* Moves the snapshot to state and waits for the adding thread to move it
+ * on, or moves it on at once if that thread is offline.
+ */
+static void TT_NAME(HandOver)(TT_TABLE *table, int state)
+{
+   table->snapshotState = state;
+   table->snapshotPending = 1;
+   if(!table->online)
+      TT_NAME(AdvanceSnapshot)(table);
+}
+
+HTEntry *TT_NAME(Snapshot)(TT_TABLE *table, unsigned *size,
+   unsigned *totalEntries)
+{
+   unsigned i, version;
+   TT_NODE *node;
+   HTEntry entry, *entries = NULL;
+
+   pthread_mutex_lock(&table->snapshotLock);
+   while(table->snapshotState != TT_IDLE)
+      pthread_cond_wait(&table->snapshotChanged, &table->snapshotLock);
+   TT_NAME(HandOver)(table, TT_REQUESTED);
+   while(table->snapshotState != TT_READING)
+      pthread_cond_wait(&table->snapshotChanged, &table->snapshotLock);
+   pthread_mutex_unlock(&table->snapshotLock);
+
+   *size = 0;
+   *totalEntries = table->snapshotTotal;
+   if(table->snapshotUnique > 0)
+      MY_MALLOC(entries, table->snapshotUnique * sizeof(HTEntry));
+
+   /* a node's version is set after its frequency is logged and before it
+    * changes, so reading it on both sides of the frequency tells whether
+    * the frequency read is the snapshot's; the key reads right either way
+    */
+   for(i = 0; i < table->snapshotSize; i++)
+      for(node = table->snapshotBuckets[i]; node != NULL; node = node->next) {
+         version = node->version;
+         TT_BARRIER();
+         entry = TT_NAME(EntryOf)(node->counted);
+         if(version < table->logStart) {
+            TT_BARRIER();
+            version = node->version;
+         }
+         if(version >= table->logStart) {
+            if(version - table->logStart >= table->logSize)
+               continue;
+            entry.frequency = table->log[version - table->logStart];
+         }
+         entries[(*size)++] = entry;
+      }
+   assert(*size == table->snapshotUnique);
+
+   pthread_mutex_lock(&table->snapshotLock);
+   TT_NAME(HandOver)(table, TT_RELEASED);
+   pthread_mutex_unlock(&table->snapshotLock);
+   return entries;
+}
+
+void TT_NAME(Quiesce)(TT_TABLE *table)
+{
+   if(!table->snapshotPending)
+      return;
+   pthread_mutex_lock(&table->snapshotLock);
+   TT_NAME(AdvanceSnapshot)(table);
+   pthread_mutex_unlock(&table->snapshotLock);
+}
+
+void TT_NAME(Online)(TT_TABLE *table)
+{
+   pthread_mutex_lock(&table->snapshotLock);
+   table->online = 1;
+   pthread_mutex_unlock(&table->snapshotLock);
+}
+
+void TT_NAME(Offline)(TT_TABLE *table)
+{
+   pthread_mutex_lock(&table->snapshotLock);
+   TT_NAME(AdvanceSnapshot)(table);
+   table->online = 0;
+   pthread_mutex_unlock(&table->snapshotLock);
+}
+#endif
+
+void *TT_NAME(Allocate)(TT_TABLE *table, size_t size)
+{
+   return regionAlloc(table->region, size);
+}
+
+void *TT_NAME(AllocateBytes)(TT_TABLE *table, size_t size)
+{
+   return regionAllocBytes(table->region, size);
+}
+
+unsigned TT_NAME(Capacity)(TT_TABLE *table)
+{
+   return CURRENT_SIZE(table);
+}
+
+unsigned TT_NAME(UniqueEntries)(TT_TABLE *table)
+{
+   return table->uniqueEntries;
+}
+
+unsigned TT_NAME(TotalEntries)(TT_TABLE *table)
+{
+   return table->totalEntries;
+}
+
+TTMetrics TT_NAME(Metrics)(TT_TABLE *table)
+{
+   unsigned i, chainLength;
+   TT_NODE *node;
+   TTMetrics metrics;
+
+   metrics.chains.numberOfChains = 0;
+   metrics.chains.maxChainLength = 0;
+
+   for(i = 0; i < CURRENT_SIZE(table); i++) {
+      chainLength = 0;
+      for(node = table->buckets[i]; node != NULL; node = node->next)
+         chainLength++;
+      if(chainLength > 0)
+         metrics.chains.numberOfChains++;
+      metrics.chains.maxChainLength = MAX(chainLength,
+         metrics.chains.maxChainLength);
+   }
+
+   metrics.chains.avgChainLength = ((float)table->uniqueEntries /
+      (float)metrics.chains.numberOfChains);
+
+#if TT_CACHE_BITS > 0
+   metrics.cacheSlots = 1 << TT_CACHE_BITS;
+   metrics.cacheHits = table->cacheHits;
+#else
+   metrics.cacheSlots = 0;
+   metrics.cacheHits = 0;
+#endif
+   metrics.cacheHitRate = table->totalEntries == 0 ? 0
+      : (float)metrics.cacheHits / (float)table->totalEntries;
+   metrics.treeConversions = table->treeConversions;
+   metrics.rehashes = table->rehashes;
+
+   return metrics;
+}
+
+#undef TT_NARROW
+#undef TT_WIDE
+#undef TT_KEY_OF
+#undef TT_FREQUENCY
+#undef TT_BATCH
+#undef TT_CACHE_SLOT
+#undef TT_CACHE_CONFIDENCE
+#undef TT_TREE
+#undef TT_PREFETCH
+#undef TT_BARRIER
+#undef TT_IDLE
+#undef TT_REQUESTED
+#undef TT_READING
+#undef TT_RELEASED
+#undef TT_FROZEN
+#undef TT_IMPLEMENTATION
+#undef TT_HASH
+#undef TT_COMPARE
+#undef TT_DESTROY
+#undef TT_KEYS_IN_REGION
+#undef TT_COUNTED
+#endif
+
+#undef TT_NODE
+#undef TT_TABLE
+#undef TT_NAME
+#undef TT_CAT
+#undef TT_CAT2
+#undef TT_KEY
+#undef TT_PREFIX
+#undef TT_CACHE_BITS
+#undef TT_TREEIFY
+#undef TT_SNAPSHOTS
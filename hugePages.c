@@ -0,0 +1,106 @@
+/* MAP_ANONYMOUS, MAP_HUGETLB and madvise are not POSIX */
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "hugePages.h"
+#include "myMacros.h"
+
+HugePageMode hugePageMode = HUGE_PAGES_OFF;
+
+/* Set once MAP_HUGETLB has failed, so the pool is not asked again. */
+static int poolEmpty;
+
+#define ROUND_UP(SIZE) \
+   (((SIZE) + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1))
+
+static int isMapped(size_t size)
+{
+   return hugePageMode != HUGE_PAGES_OFF && size >= HUGE_PAGE_SIZE;
+}
+
+static void mapFailed(void)
+{
+   perror("wf: mmap");
+   exit(EXIT_FAILURE);
+}
+
+/* Maps size bytes, a multiple of HUGE_PAGE_SIZE, aligned to a huge page so
+ * the kernel can back all of it with them, by mapping a huge page more and
+ * unmapping what sticks out on either side.
+ */
+static void *mapTransparent(size_t size)
+{
+   char *mapping, *start;
+   size_t head;
+
+   mapping = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if(mapping == MAP_FAILED)
+      mapFailed();
+
+   head = (HUGE_PAGE_SIZE - (unsigned long)mapping % HUGE_PAGE_SIZE)
+      % HUGE_PAGE_SIZE;
+   start = mapping + head;
+   if(head > 0)
+      munmap(mapping, head);
+   munmap(start + size, HUGE_PAGE_SIZE - head);
+
+   /* without transparent huge pages this fails and changes nothing */
+   madvise(start, size, MADV_HUGEPAGE);
+   return start;
+}
+
+static void *mapExplicit(size_t size)
+{
+   void *mapping;
+
+   if(!poolEmpty) {
+      mapping = mmap(NULL, size, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if(mapping != MAP_FAILED)
+         return mapping;
+      poolEmpty = 1;
+      fprintf(stderr, "wf: no reserved huge pages left (see "
+         "/proc/sys/vm/nr_hugepages), using transparent ones\n");
+   }
+   return mapTransparent(size);
+}
+
+void *hugeAlloc(size_t size, int zeroed, MemCategory category)
+{
+   void *memory;
+
+   if(!isMapped(size)) {
+      if(zeroed)
+         MY_CALLOC(memory, size, char);
+      else
+         MY_MALLOC(memory, size);
+      memAllocated(category, size);
+      return memory;
+   }
+
+   /* fresh mappings are zeroed anyway */
+   if(hugePageMode == HUGE_PAGES_EXPLICIT)
+      memory = mapExplicit(ROUND_UP(size));
+   else
+      memory = mapTransparent(ROUND_UP(size));
+   memCount(category, (long)size);
+   memCount(MEM_MALLOC_OVERHEAD, (long)(ROUND_UP(size) - size));
+   return memory;
+}
+
+void hugeFree(void *memory, size_t size, MemCategory category)
+{
+   if(memory == NULL)
+      return;
+   if(!isMapped(size)) {
+      free(memory);
+      memFreed(category, size);
+      return;
+   }
+
+   munmap(memory, ROUND_UP(size));
+   memCount(MEM_MALLOC_OVERHEAD, -(long)(ROUND_UP(size) - size));
+   memCount(category, -(long)size);
+}
@@ -0,0 +1,51 @@
+#ifndef HUGEPAGES_H
+#define HUGEPAGES_H
+
+#include <stddef.h>
+#include "memReport.h"
+
+/* Huge page backing for the big, randomly accessed allocations: the hash
+ * table's bucket arrays and the region chunks that hold its nodes, words
+ * and keys, for --huge-pages.
+ *
+ * With 4 KB pages, a bucket array of a few hundred MB is tens of thousands
+ * of pages, far more than the TLB covers, so nearly every add that touches
+ * a random bucket also misses the TLB. With 2 MB pages the same array is a
+ * few hundred pages.
+ *
+ * Allocations of at least HUGE_PAGE_SIZE are mapped on their own, rounded
+ * up to whole huge pages and aligned to one. HUGE_PAGES_TRANSPARENT asks
+ * the kernel for transparent huge pages with madvise(MADV_HUGEPAGE); where
+ * it has them disabled the memory is simply made of small pages.
+ * HUGE_PAGES_EXPLICIT maps from the reserved hugetlbfs pool (MAP_HUGETLB),
+ * and falls back to transparent huge pages, with a warning, once the pool
+ * runs dry or was never reserved. Smaller allocations, and every
+ * allocation with HUGE_PAGES_OFF, come from malloc.
+ *
+ * No memory is touched here, so its pages end up on the NUMA node of the
+ * thread that first writes to them, the one that uses them.
+ */
+typedef enum {
+   HUGE_PAGES_OFF,
+   HUGE_PAGES_TRANSPARENT,
+   HUGE_PAGES_EXPLICIT
+} HugePageMode;
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* Set before the first allocation, it must not change afterwards. */
+extern HugePageMode hugePageMode;
+
+/* Description: Allocates size bytes, zeroed when zeroed is set, and counts
+ *    them in the --mem-report category (the rounding to whole huge pages
+ *    as malloc overhead). Failures are reported and the program exits,
+ *    like MY_MALLOC.
+ */
+void *hugeAlloc(size_t size, int zeroed, MemCategory category);
+
+/* Description: Frees memory returned by hugeAlloc for the same size and
+ *    uncounts it.
+ */
+void hugeFree(void *memory, size_t size, MemCategory category);
+
+#endif
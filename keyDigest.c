@@ -0,0 +1,128 @@
+#include <string.h>
+#include "keyDigest.h"
+
+#define ROTR(X, R) ((((X) >> (R)) | ((X) << (32 - (R)))) & 0xffffffffu)
+
+#define DIGEST_SIZE 16
+#define BLOCK_SIZE 64
+
+static const char hexDigits[] = "0123456789abcdef";
+
+static const unsigned long initial[8] = {
+   0x6a09e667ul, 0xbb67ae85ul, 0x3c6ef372ul, 0xa54ff53aul,
+   0x510e527ful, 0x9b05688cul, 0x1f83d9abul, 0x5be0cd19ul
+};
+
+static const unsigned char sigma[10][16] = {
+   { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
+   {14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3},
+   {11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4},
+   { 7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8},
+   { 9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13},
+   { 2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9},
+   {12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11},
+   {13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10},
+   { 6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5},
+   {10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0}
+};
+
+/* Reads 4 bytes as a little-endian number, whatever the byte order and
+ * alignment of the machine.
+ */
+static unsigned long readWord(const Byte *bytes)
+{
+   return (unsigned long)bytes[0] | (unsigned long)bytes[1] << 8
+      | (unsigned long)bytes[2] << 16 | (unsigned long)bytes[3] << 24;
+}
+
+#define MIX(A, B, C, D, X, Y) \
+   do { \
+      v[A] = (v[A] + v[B] + (X)) & 0xffffffffu; \
+      v[D] = ROTR(v[D] ^ v[A], 16); \
+      v[C] = (v[C] + v[D]) & 0xffffffffu; \
+      v[B] = ROTR(v[B] ^ v[C], 12); \
+      v[A] = (v[A] + v[B] + (Y)) & 0xffffffffu; \
+      v[D] = ROTR(v[D] ^ v[A], 8); \
+      v[C] = (v[C] + v[D]) & 0xffffffffu; \
+      v[B] = ROTR(v[B] ^ v[C], 7); \
+   } while(0)
+
+/* Compresses one block into h. count is the number of bytes hashed so far,
+ * this block included, and last is set for the final block.
+ */
+static void compress(unsigned long h[8], const Byte *block,
+   unsigned long count, int last)
+{
+   unsigned long m[16], v[16];
+   const unsigned char *s;
+   int i;
+
+   for(i = 0; i < 16; i++)
+      m[i] = readWord(block + 4 * i);
+   for(i = 0; i < 8; i++) {
+      v[i] = h[i];
+      v[i + 8] = initial[i];
+   }
+   /* the byte count is 64 bits; tokens stay far below 2^32 bytes */
+   v[12] ^= count & 0xffffffffu;
+   if(last)
+      v[14] ^= 0xffffffffu;
+
+   for(i = 0; i < 10; i++) {
+      s = sigma[i];
+      MIX(0, 4,  8, 12, m[s[ 0]], m[s[ 1]]);
+      MIX(1, 5,  9, 13, m[s[ 2]], m[s[ 3]]);
+      MIX(2, 6, 10, 14, m[s[ 4]], m[s[ 5]]);
+      MIX(3, 7, 11, 15, m[s[ 6]], m[s[ 7]]);
+      MIX(0, 5, 10, 15, m[s[ 8]], m[s[ 9]]);
+      MIX(1, 6, 11, 12, m[s[10]], m[s[11]]);
+      MIX(2, 7,  8, 13, m[s[12]], m[s[13]]);
+      MIX(3, 4,  9, 14, m[s[14]], m[s[15]]);
+   }
+
+   for(i = 0; i < 8; i++)
+      h[i] ^= v[i] ^ v[i + 8];
+}
+
+/* BLAKE2s (RFC 7693), unkeyed, with a 16 byte digest. */
+static void blake2s128(const Byte *bytes, unsigned length,
+   Byte digest[DIGEST_SIZE])
+{
+   unsigned long h[8];
+   Byte last[BLOCK_SIZE];
+   unsigned long count = 0;
+   int i;
+
+   for(i = 0; i < 8; i++)
+      h[i] = initial[i];
+   /* parameter block: digest size, no key, fanout and depth 1 */
+   h[0] ^= 0x01010000ul | DIGEST_SIZE;
+
+   for(; length > BLOCK_SIZE; bytes += BLOCK_SIZE, length -= BLOCK_SIZE)
+      compress(h, bytes, count += BLOCK_SIZE, 0);
+
+   memset(last, 0, BLOCK_SIZE);
+   memcpy(last, bytes, length);
+   compress(h, last, count + length, 1);
+
+   for(i = 0; i < DIGEST_SIZE; i++)
+      digest[i] = (Byte)(h[i / 4] >> (8 * (i % 4)));
+}
+
+unsigned digestKey(const Byte *bytes, unsigned length, unsigned maxLength,
+   Byte *key)
+{
+   Byte digest[DIGEST_SIZE];
+   Byte *out = key + maxLength;
+   int i;
+
+   blake2s128(bytes, length, digest);
+
+   memcpy(key, bytes, maxLength);
+   *out++ = '#';
+   for(i = 0; i < DIGEST_SIZE; i++) {
+      *out++ = hexDigits[digest[i] >> 4];
+      *out++ = hexDigits[digest[i] & 0xf];
+   }
+   return maxLength + DIGEST_KEY_GROWTH;
+}
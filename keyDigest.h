@@ -0,0 +1,37 @@
+#ifndef KEYDIGEST_H
+#define KEYDIGEST_H
+
+#include "getWord.h"
+
+/* Fixed size keys for overlong tokens, for --max-key N.
+ *
+ * Binary input holds "words" of megabytes, which would otherwise be copied
+ * into the table whole and hashed and compared in full on every count. A
+ * token longer than N bytes is counted instead as its first N bytes, a '#'
+ * and the 32 hex digits of the 128-bit BLAKE2s digest (RFC 7693) of all of
+ * its bytes, so it costs N + 33 bytes and hashes and compares in time
+ * independent of its length.
+ *
+ * Two different tokens only share a key if they share the first N bytes
+ * and the digest. BLAKE2s is a cryptographic hash, so even input built to
+ * collide needs about 2^64 work to find such a pair, and the keys are the
+ * same from run to run. No token that is counted as itself is longer than N,
+ * so none can be mistaken for such a key, and the key holds no whitespace,
+ * so n-grams of keys stay unambiguous.
+ */
+#define DIGEST_KEY_GROWTH 33
+
+/* Description: Writes the key of the token to key, which has room for
+ *    maxLength + DIGEST_KEY_GROWTH bytes.
+ *
+ * Parameters:
+ *    bytes, length: The token, longer than maxLength.
+ *    maxLength: N of --max-key N.
+ *    key: Output, the key.
+ *
+ * Return: The length of the key, maxLength + DIGEST_KEY_GROWTH.
+ */
+unsigned digestKey(const Byte *bytes, unsigned length, unsigned maxLength,
+   Byte *key);
+
+#endif
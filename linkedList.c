@@ -10,31 +10,29 @@ int findNode(ListNode ** nodePointer, void *data, FNCompare compare){
    if(*nodePointer == NULL)
       return 0;
 
-   while((*compare)(data, (*nodePointer)->entry->data)) {
-      if((*nodePointer)->next == NULL)
+   while((*compare)(data, NODE_DATA(*nodePointer))) {
+      if(NODE_NEXT(*nodePointer) == NULL)
          return 2;
-      *nodePointer = (*nodePointer)->next;
+      *nodePointer = NODE_NEXT(*nodePointer);
    }
    return 1;
 }
 
 void addListToEntryList(HTEntry* entryArray, ListNode * head, unsigned *size)
 {
-   ListNode* nodePointer;
    while(head != NULL){
-      nodePointer = head;
-      head = head->next;
-      entryArray[((*size)++)] = *(nodePointer->entry);
+      entryArray[*size].data = NODE_DATA(head);
+      entryArray[((*size)++)].frequency = NODE_FREQUENCY(head);
+      head = NODE_NEXT(head);
    }
 }
 
+/* The nodes themselves are freed with the region. */
 void destroyNode(ListNode * node, FNDestroy destroy) {
 
    if(destroy != NULL)
-      destroy(((node->entry)->data));
-   free((node->entry->data));
-   free(node->entry);
-   free(node);
+      destroy(NODE_DATA(node));
+   free(NODE_DATA(node));
 }
 
 void destroyList(ListNode *head, FNDestroy destroy) {
@@ -42,24 +40,46 @@ void destroyList(ListNode *head, FNDestroy destroy) {
    ListNode* nodePointer;
    while(head != NULL){
       nodePointer = head;
-      head = head->next;
+      head = NODE_NEXT(head);
       destroyNode(nodePointer, destroy);
    }
 }
 
-ListNode *createListNode(void *data) {
+ListNode *createListNode(void *data, Region *region) {
 
-   HTEntry *newEntry;
-   ListNode *newNode;
-   MY_CALLOC(newNode, 1, ListNode);
-   MY_CALLOC(newEntry, 1, HTEntry);
-   newNode->entry = newEntry;
-   newEntry->data = data;
-   newEntry->frequency = 1;
+   ListNode *newNode = regionAlloc(region, sizeof(ListNode));
+   memCount(MEM_NODES, sizeof(ListNode));
+   newNode->data = data;
+   newNode->next = (ListNode *)REGION_TAGGED(NULL, 1);
    return newNode;
 }
 
-unsigned addListEntry(ListNode **head, void *data, FNCompare compare){
+/* Adds one to the node's frequency and returns it, moving it to a wide
+ * counter when the count bits overflow.
+ */
+unsigned countNode(ListNode *node, Region *region) {
+
+   HTEntry *wide;
+   unsigned count = NODE_COUNT(node);
+
+   if(count == 0)
+      return ++NODE_WIDE(node)->frequency;
+   if(count < NARROW_MAX) {
+      node->next = (ListNode *)REGION_TAGGED(NODE_NEXT(node), count + 1);
+      return count + 1;
+   }
+
+   wide = regionAlloc(region, sizeof(HTEntry));
+   memCount(MEM_NODES, sizeof(HTEntry));
+   wide->data = node->data;
+   wide->frequency = count + 1;
+   node->data = wide;
+   node->next = NODE_NEXT(node);
+   return wide->frequency;
+}
+
+unsigned addListEntry(ListNode **head, void *data, FNCompare compare,
+   Region *region){
 
    int Flag;
    ListNode *nodePointer;
@@ -67,22 +87,17 @@ unsigned addListEntry(ListNode **head, void *data, FNCompare compare){
 
    Flag = findNode(&nodePointer, data, compare);
 
-   if(Flag == 0){
-      *head = createListNode(data);
-      nodePointer = *head;
-   }
+   if(Flag == 0)
+      *head = createListNode(data, region);
    else if(Flag == 1)
-      nodePointer->entry->frequency ++;
-   else if(Flag == 2){
-      nodePointer->next = createListNode(data);
-      return 1;
-   }
+      return countNode(nodePointer, region);
+   else if(Flag == 2)
+      SET_NEXT(nodePointer, createListNode(data, region));
 
-   return nodePointer->entry->frequency;
+   return 1;
 }
 
 void addHead(ListNode **list, ListNode *newNode) {
-   newNode->next = *list;
+   SET_NEXT(newNode, *list);
    *list = newNode;
 }
-
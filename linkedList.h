@@ -3,14 +3,34 @@
 
 #include "hashTable.h"
 
+#include "region.h"
+
+/* A chain node is two pointers. Nodes come from a region, so next carries
+ * a region tag (see region.h) and the tag is the frequency, as long as it
+ * fits: up to 7 with 8 byte pointers, 3 with 4 byte ones, while most keys
+ * of a large vocabulary are seen once or twice. When it outgrows the tag
+ * the tag becomes 0 and data is swapped for a wide counter, an HTEntry
+ * holding the data and its full frequency, allocated from the same region.
+ */
 typedef struct node
 {
-   HTEntry *entry;
+   void *data;
    struct node *next;
 } ListNode;
 
-#define NODE_ENTRY(NODE) ((HTEntry *)(NODE)->entry)
-#define NODE_ENTR(NODE) ((HTEntry *)(&(NODE->entry)))
+#define NARROW_MAX REGION_TAG_MAX
+
+#define NODE_COUNT(NODE) REGION_TAG((NODE)->next)
+#define NODE_NEXT(NODE) ((ListNode *)REGION_UNTAG((NODE)->next))
+#define NODE_WIDE(NODE) ((HTEntry *)(NODE)->data)
+#define NODE_DATA(NODE) \
+   (NODE_COUNT(NODE) ? (NODE)->data : NODE_WIDE(NODE)->data)
+#define NODE_FREQUENCY(NODE) \
+   (NODE_COUNT(NODE) ? NODE_COUNT(NODE) : NODE_WIDE(NODE)->frequency)
+
+/* Points the node at next, keeping its count bits. */
+#define SET_NEXT(NODE, NEXT) \
+   ((NODE)->next = (ListNode *)REGION_TAGGED(NEXT, NODE_COUNT(NODE)))
 /*
  * Adds the value to the front of the list. Has O(1) performance.
  *
@@ -52,7 +72,8 @@ ListNode* deleteNode(ListNode *list, int index);
  */
 void printList(ListNode *list);
 
-unsigned addListEntry(ListNode **head, void *data, FNCompare compare);
+unsigned addListEntry(ListNode **head, void *data, FNCompare compare,
+   Region *region);
 
 int findNode(ListNode ** nodePointer, void *data, FNCompare compare);
 
@@ -0,0 +1,42 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "mappedFile.h"
+#include "myMacros.h"
+
+MappedFile *mapFile(FILE *file, MappedFile **list)
+{
+   struct stat info;
+   void *start;
+   MappedFile *mapping;
+
+   if(fstat(fileno(file), &info) != 0 || !S_ISREG(info.st_mode)
+      || info.st_size == 0)
+      return NULL;
+
+   start = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+   if(start == MAP_FAILED)
+      return NULL;
+   posix_madvise(start, info.st_size, POSIX_MADV_SEQUENTIAL);
+
+   MY_MALLOC(mapping, sizeof(MappedFile));
+   mapping->start = start;
+   mapping->end = mapping->start + info.st_size;
+   mapping->next = *list;
+   *list = mapping;
+   return mapping;
+}
+
+void unmapFiles(MappedFile *list)
+{
+   MappedFile *next;
+
+   while(list != NULL) {
+      next = list->next;
+      munmap(list->start, list->end - list->start);
+      free(list);
+      list = next;
+   }
+}
@@ -0,0 +1,30 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stdio.h>
+#include "getWord.h"
+
+/* A read-only mapping of an input file. Mappings are kept on a list so they
+ * can outlive the file they came from: words counted straight out of the
+ * mapping point into it until the table is destroyed.
+ */
+typedef struct MappedFile {
+   Byte *start;
+   Byte *end;
+   struct MappedFile *next;
+} MappedFile;
+
+/* Description: Maps the open file and pushes the mapping on the list.
+ *
+ * Return: The new mapping, or NULL when the file cannot be mapped (it is not
+ *    a regular file, it is empty, or mmap fails); the caller should then read
+ *    it with stdio instead.
+ */
+MappedFile *mapFile(FILE *file, MappedFile **list);
+
+/* Description: Unmaps every mapping on the list and frees the list. Nothing
+ *    may point into the mappings afterwards.
+ */
+void unmapFiles(MappedFile *list);
+
+#endif
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+#include "memReport.h"
+
+#define MAX(A,B) (((A) > (B)) ? (A):(B))
+
+/* glibc serves requests from this size up with mmap (its default), page
+ * aligned; smaller ones get a size word and are rounded to 16 bytes.
+ */
+#define MMAP_THRESHOLD (128 * 1024)
+#define PAGE_SIZE 4096
+#define MIN_CHUNK (4 * sizeof(size_t))
+#define CHUNK_ALIGN (2 * sizeof(size_t))
+
+#define MB (1024.0 * 1024.0)
+
+static const char *categoryNames[MEM_CATEGORIES] = {
+   "bucket array",
+   "table nodes",
+   "chain trees",
+   "front cache",
+   "Word structs",
+   "key bytes",
+   "result arrays",
+   "region slack",
+   "malloc overhead"
+};
+
+static long current[MEM_CATEGORIES];
+static long peak[MEM_CATEGORIES];
+static long total, totalPeak;
+
+void memCount(MemCategory category, long bytes)
+{
+   current[category] += bytes;
+   if(current[category] > peak[category])
+      peak[category] = current[category];
+
+   total += bytes;
+   if(total > totalPeak)
+      totalPeak = total;
+}
+
+static size_t mallocOverhead(size_t size)
+{
+   size_t chunk;
+
+   if(size >= MMAP_THRESHOLD)
+      chunk = (size + sizeof(size_t) + PAGE_SIZE - 1)
+         & ~(size_t)(PAGE_SIZE - 1);
+   else
+      chunk = MAX(MIN_CHUNK, (size + sizeof(size_t) + CHUNK_ALIGN - 1)
+         & ~(CHUNK_ALIGN - 1));
+   return chunk - size;
+}
+
+void memAllocated(MemCategory category, size_t size)
+{
+   memCount(category, (long)size);
+   memCount(MEM_MALLOC_OVERHEAD, (long)mallocOverhead(size));
+}
+
+void memFreed(MemCategory category, size_t size)
+{
+   memCount(MEM_MALLOC_OVERHEAD, -(long)mallocOverhead(size));
+   memCount(category, -(long)size);
+}
+
+/* Reads a "Name:   1234 kB" line of a /proc file, in bytes. Returns -1
+ * when there is no such file or line.
+ */
+static double readProc(const char *path, const char *name)
+{
+   FILE *status = fopen(path, "r");
+   char line[256];
+   double kilobytes = -1;
+   size_t length = strlen(name);
+
+   if(status == NULL)
+      return -1;
+   while(fgets(line, sizeof(line), status) != NULL)
+      if(!strncmp(line, name, length) && line[length] == ':') {
+         if(1 != sscanf(line + length + 1, "%lf", &kilobytes))
+            kilobytes = -1;
+         break;
+      }
+   fclose(status);
+   return kilobytes < 0 ? -1 : kilobytes * 1024;
+}
+
+void writeMemReport(FILE *out, unsigned uniqueWords, unsigned vocabulary,
+   double bucketBytes, double previousBucketBytes)
+{
+   int i;
+   double perWord, resultsPerWord, projected;
+   double rss = readProc("/proc/self/status", "VmRSS");
+   double rssPeak = readProc("/proc/self/status", "VmHWM");
+   double transparent = readProc("/proc/self/smaps_rollup", "AnonHugePages");
+   double hugetlb = readProc("/proc/self/status", "HugetlbPages");
+
+   fprintf(out, "wf: %-18s %14s %14s\n", "memory (bytes)", "current",
+      "peak");
+   for(i = 0; i < MEM_CATEGORIES; i++)
+      fprintf(out, "wf:   %-16s %14ld %14ld\n", categoryNames[i],
+         current[i], peak[i]);
+   fprintf(out, "wf:   %-16s %14ld %14ld\n", "total", total, totalPeak);
+
+   if(rss >= 0 && rssPeak >= 0)
+      fprintf(out, "wf: resident %.1f MB, peak %.1f MB\n", rss / MB,
+         rssPeak / MB);
+   if(transparent > 0 || hugetlb > 0)
+      fprintf(out, "wf: huge pages %.1f MB transparent, %.1f MB explicit\n",
+         MAX(transparent, 0) / MB, MAX(hugetlb, 0) / MB);
+
+   if(uniqueWords == 0)
+      return;
+
+   /* everything but the parts sized by the table or the result count */
+   perWord = (double)(total - current[MEM_BUCKETS] - current[MEM_CACHE]
+      - current[MEM_RESULTS]) / uniqueWords;
+   resultsPerWord = (double)peak[MEM_RESULTS] / uniqueWords;
+   fprintf(out, "wf: %.1f bytes per unique word, %.1f with buckets and "
+      "results\n", perWord, (double)totalPeak / uniqueWords);
+
+   projected = vocabulary * perWord + current[MEM_CACHE] + bucketBytes
+      + MAX(previousBucketBytes, vocabulary * resultsPerWord);
+   fprintf(out, "wf: projected peak for %u unique words: %.1f MB\n",
+      vocabulary, projected / MB);
+}
@@ -0,0 +1,66 @@
+#ifndef MEMREPORT_H
+#define MEMREPORT_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+/* Memory accounting for --mem-report.
+ *
+ * The structures that grow with the input count their allocations here by
+ * category, through MY_MALLOC_COUNTED and MY_CALLOC_COUNTED (myMacros.h)
+ * for malloc'ed memory and memCount for memory carved out of a region.
+ * Region chunks are counted as slack when they are allocated and handed
+ * over, byte for byte, to a category as they are carved up, so the total
+ * is what was really requested from malloc.
+ *
+ * Frees are counted where memory is released during a run (old bucket
+ * arrays, grown radix tree nodes, sort scratch). Teardown at exit is not
+ * always counted; the report is written before it.
+ */
+typedef enum {
+   MEM_BUCKETS,         /* hash table bucket arrays */
+   MEM_NODES,           /* hash table nodes, radix tree nodes and leaves */
+   MEM_TREES,           /* trees over overlong chains */
+   MEM_CACHE,           /* the hash table's front cache */
+   MEM_WORDS,           /* Word structs of the keys */
+   MEM_KEYS,            /* key bytes */
+   MEM_RESULTS,         /* the entry array and sort scratch */
+   MEM_REGION_SLACK,    /* region chunk bytes not handed out */
+   MEM_MALLOC_OVERHEAD, /* malloc headers and rounding, estimated */
+   MEM_CATEGORIES
+} MemCategory;
+
+/* Description: Adds bytes (negative when freed) to the category and
+ *    updates its peak and the peak of the total.
+ */
+void memCount(MemCategory category, long bytes);
+
+/* Description: Counts a malloc of size bytes, plus the estimated glibc
+ *    overhead of the allocation as MEM_MALLOC_OVERHEAD.
+ */
+void memAllocated(MemCategory category, size_t size);
+
+/* Description: Undoes memAllocated for a freed allocation of size bytes.
+ */
+void memFreed(MemCategory category, size_t size);
+
+/* Description: Writes the current and peak bytes of every category and of
+ *    the total, the average bytes per unique word, the resident set size
+ *    and how much of it is huge pages as reported by /proc (when
+ *    available) and the projected peak for a vocabulary of the given
+ *    size.
+ *
+ * Parameters:
+ *    out: Where to write, e.g. stderr.
+ *    uniqueWords: The number of words counted so far.
+ *    vocabulary: The number of unique words to project to.
+ *    bucketBytes, previousBucketBytes: The bucket array at that
+ *       vocabulary and the one before it, which coexist while rehashing.
+ *       Both 0 when counting without a hash table.
+ *
+ * Return: None
+ */
+void writeMemReport(FILE *out, unsigned uniqueWords, unsigned vocabulary,
+   double bucketBytes, double previousBucketBytes);
+
+#endif
@@ -3,6 +3,14 @@
 
 #include "hashTable.h"
 #include "linkedList.h"
+#include "memReport.h"
+
+/* An entry of a frozen table, see frozenTable.h. */
+typedef struct {
+   void *data;
+   unsigned frequency;
+   unsigned hash;
+} FrozenEntry;
 
 typedef struct {
 
@@ -15,7 +23,13 @@ typedef struct {
    ListNode **actualHT;
    unsigned totalEntries;
    unsigned uniqueEntries;
+   Region *region;
 
+   /* Set by htFreeze, which frees actualHT and region. Bucket i holds
+    * frozen[starts[i]] up to frozen[starts[i + 1]].
+    */
+   FrozenEntry *frozen;
+   unsigned *starts;
 
 } HashTable;
 
@@ -46,5 +60,20 @@ typedef struct {
    } while(0)
 
 /*#undef MY_CALLOC*/
+
+/* MY_MALLOC and MY_CALLOC that also count the allocation in a --mem-report
+ * category, see memReport.h.
+ */
+#define MY_MALLOC_COUNTED(_ptr,_size,_category) \
+   do { \
+       MY_MALLOC(_ptr,_size); \
+       memAllocated(_category, _size); \
+   } while(0)
+
+#define MY_CALLOC_COUNTED(_ptr,_num,_type,_category) \
+   do { \
+       MY_CALLOC(_ptr,_num,_type); \
+       memAllocated(_category, (_num) * sizeof(_type)); \
+   } while(0)
 #endif
 
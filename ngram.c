@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ngram.h"
+#include "myMacros.h"
+
+/* The multiplier of the n-gram hash polynomial, odd so it is invertible
+ * modulo the word size.
+ */
+#define NGRAM_MULTIPLIER 0x9e3779b1u
+
+/* The joined tokens are buffer[start, start + used). lengths and hashes
+ * are rings of the window's tokens, oldest at first.
+ */
+struct NGram {
+   unsigned k;
+   unsigned *lengths;
+   unsigned *hashes;
+   unsigned first;
+   unsigned count;
+
+   Byte *buffer;
+   unsigned bufferSize;
+   unsigned start;
+   unsigned used;
+
+   unsigned hash;
+   unsigned dropFactor;
+};
+
+NGram *ngramCreate(unsigned k)
+{
+   NGram *ngram;
+   unsigned i;
+
+   MY_CALLOC(ngram, 1, NGram);
+   MY_MALLOC(ngram->lengths, k * sizeof(unsigned));
+   MY_MALLOC(ngram->hashes, k * sizeof(unsigned));
+   ngram->k = k;
+
+   /* NGRAM_MULTIPLIER^(k-1), the weight of the oldest token */
+   ngram->dropFactor = 1;
+   for(i = 1; i < k; i++)
+      ngram->dropFactor *= NGRAM_MULTIPLIER;
+   return ngram;
+}
+
+void ngramDestroy(NGram *ngram)
+{
+   free(ngram->lengths);
+   free(ngram->hashes);
+   free(ngram->buffer);
+   free(ngram);
+}
+
+void ngramReset(NGram *ngram)
+{
+   ngram->first = 0;
+   ngram->count = 0;
+   ngram->start = 0;
+   ngram->used = 0;
+   ngram->hash = 0;
+}
+
+static void dropOldest(NGram *ngram)
+{
+   /* the token and the space after it, if any */
+   unsigned length = ngram->lengths[ngram->first] + (ngram->count > 1);
+
+   ngram->start += length;
+   ngram->used -= length;
+   ngram->hash -= ngram->hashes[ngram->first] * ngram->dropFactor;
+   ngram->first = (ngram->first + 1) % ngram->k;
+   ngram->count--;
+}
+
+/* Makes room for length more bytes after the window, moving it to the
+ * front of the buffer or growing the buffer.
+ */
+static void reserve(NGram *ngram, unsigned length)
+{
+   Byte *grown;
+
+   if(ngram->start + ngram->used + length <= ngram->bufferSize)
+      return;
+
+   if(ngram->used + length <= ngram->bufferSize / 2) {
+      memmove(ngram->buffer, ngram->buffer + ngram->start, ngram->used);
+      ngram->start = 0;
+      return;
+   }
+
+   ngram->bufferSize = MAX(2 * (ngram->used + length), 256);
+   MY_MALLOC(grown, ngram->bufferSize);
+   if(ngram->used > 0)
+      memcpy(grown, ngram->buffer + ngram->start, ngram->used);
+   free(ngram->buffer);
+   ngram->buffer = grown;
+   ngram->start = 0;
+}
+
+int ngramPush(NGram *ngram, const Byte *token, unsigned length,
+   Byte **bytes, unsigned *ngramLength, unsigned *hash)
+{
+   Word word;
+   unsigned last;
+
+   if(ngram->count == ngram->k)
+      dropOldest(ngram);
+
+   reserve(ngram, length + 1);
+   if(ngram->count > 0)
+      ngram->buffer[ngram->start + ngram->used++] = ' ';
+   memcpy(ngram->buffer + ngram->start + ngram->used, token, length);
+   ngram->used += length;
+
+   word.bytes = (Byte *)token;
+   word.length = length;
+   last = (ngram->first + ngram->count) % ngram->k;
+   ngram->lengths[last] = length;
+   ngram->hashes[last] = hashWord(&word);
+   ngram->hash = ngram->hash * NGRAM_MULTIPLIER + ngram->hashes[last];
+   ngram->count++;
+
+   if(ngram->count < ngram->k)
+      return 0;
+
+   *bytes = ngram->buffer + ngram->start;
+   *ngramLength = ngram->used;
+   *hash = ngram->hash;
+   return 1;
+}
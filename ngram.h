@@ -0,0 +1,38 @@
+#ifndef NGRAM_H
+#define NGRAM_H
+
+#include "getWord.h"
+
+/* The sliding window of the last K tokens for --ngram K.
+ *
+ * The window keeps the tokens' bytes joined by single spaces (tokens never
+ * contain whitespace, so the join is unambiguous) and one hash per token.
+ * The n-gram hash is a polynomial in the token hashes, updated in constant
+ * time as tokens enter and leave, so the joined bytes are never rehashed.
+ * Pushing a token costs its own length plus amortized compaction of the
+ * window, independent of K.
+ */
+typedef struct NGram NGram;
+
+NGram *ngramCreate(unsigned k);
+void ngramDestroy(NGram *ngram);
+
+/* Description: Empties the window, so n-grams never span two files.
+ */
+void ngramReset(NGram *ngram);
+
+/* Description: Slides the token into the window.
+ *
+ * Parameters:
+ *    token, length: The token, copied into the window.
+ *    bytes, ngramLength: Output, the joined n-gram. Valid until the next
+ *       call.
+ *    hash: Output, the n-gram hash.
+ *
+ * Return: 1 when the window holds K tokens and the outputs are set,
+ *    otherwise 0.
+ */
+int ngramPush(NGram *ngram, const Byte *token, unsigned length,
+   Byte **bytes, unsigned *ngramLength, unsigned *hash);
+
+#endif
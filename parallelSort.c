@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "parallelSort.h"
+#include "qsortHTEntries.h"
+#include "myMacros.h"
+
+/* Below this many entries per thread the thread overhead is not worth it.
+ */
+#define MIN_PER_THREAD 16384
+
+int compareEntry(const void *e1, const void *e2);
+
+typedef struct {
+   HTEntry *entries;
+   unsigned count;
+} SortTask;
+
+/* Merges the output range [from, to) of the merge of runs a and b into out.
+ */
+typedef struct {
+   HTEntry *a, *b, *out;
+   unsigned n, m;
+   unsigned from, to;
+} MergeTask;
+
+static void *sortRun(void *arg)
+{
+   SortTask *task = (SortTask *)arg;
+   qsortHTEntries(task->entries, task->count);
+   return NULL;
+}
+
+/* Returns how many of the first k merged entries come from a. Ties take
+ * from a first, which keeps the merge stable.
+ */
+static unsigned coRank(unsigned k, HTEntry *a, unsigned n, HTEntry *b,
+   unsigned m)
+{
+   unsigned lo = k > m ? k - m : 0;
+   unsigned hi = MIN(k, n);
+   unsigned i;
+
+   while(lo < hi) {
+      i = lo + (hi - lo) / 2;
+      if(compareEntry(&a[i], &b[k - i - 1]) <= 0)
+         lo = i + 1;
+      else
+         hi = i;
+   }
+   return lo;
+}
+
+static void *mergeRange(void *arg)
+{
+   MergeTask *task = (MergeTask *)arg;
+   unsigned i = coRank(task->from, task->a, task->n, task->b, task->m);
+   unsigned j = task->from - i;
+   unsigned iEnd = coRank(task->to, task->a, task->n, task->b, task->m);
+   unsigned jEnd = task->to - iEnd;
+   HTEntry *out = task->out + task->from;
+
+   while(i < iEnd && j < jEnd) {
+      if(compareEntry(&task->a[i], &task->b[j]) <= 0)
+         *out++ = task->a[i++];
+      else
+         *out++ = task->b[j++];
+   }
+   memcpy(out, task->a + i, (iEnd - i) * sizeof(HTEntry));
+   out += iEnd - i;
+   memcpy(out, task->b + j, (jEnd - j) * sizeof(HTEntry));
+   return NULL;
+}
+
+/* Runs every task, the first one on the calling thread. A task whose thread
+ * cannot be created is run inline instead.
+ */
+static void runTasks(void *(*work)(void *), char *tasks, size_t taskSize,
+   int numTasks)
+{
+   int i;
+   pthread_t *threads;
+   int *started;
+
+   MY_CALLOC(threads, numTasks, pthread_t);
+   MY_CALLOC(started, numTasks, int);
+
+   for(i = 1; i < numTasks; i++)
+      started[i] = (0 == pthread_create(&threads[i], NULL, work,
+         tasks + i * taskSize));
+
+   work(tasks);
+   for(i = 1; i < numTasks; i++) {
+      if(started[i])
+         pthread_join(threads[i], NULL);
+      else
+         work(tasks + i * taskSize);
+   }
+
+   free(threads);
+   free(started);
+}
+
+/* Merges neighbouring runs of src into dst, halving the number of runs.
+ * Each pair gets a share of the threads proportional to its size.
+ */
+static unsigned mergeRound(HTEntry *src, HTEntry *dst, unsigned *bounds,
+   unsigned numRuns, int numThreads)
+{
+   unsigned total = bounds[numRuns];
+   unsigned pair, part, parts, first, middle, last;
+   int numTasks = 0;
+   MergeTask *tasks;
+
+   MY_CALLOC(tasks, numRuns + numThreads, MergeTask);
+
+   for(pair = 0; pair < numRuns; pair += 2) {
+      first = bounds[pair];
+      middle = bounds[pair + 1];
+      last = (pair + 2 <= numRuns) ? bounds[pair + 2] : middle;
+
+      parts = (unsigned)(((double)(last - first) / total) * numThreads);
+      parts = MAX(parts, 1);
+      for(part = 0; part < parts; part++) {
+         tasks[numTasks].a = src + first;
+         tasks[numTasks].n = middle - first;
+         tasks[numTasks].b = src + middle;
+         tasks[numTasks].m = last - middle;
+         tasks[numTasks].out = dst + first;
+         tasks[numTasks].from = (unsigned)
+            ((double)(last - first) * part / parts);
+         tasks[numTasks].to = (unsigned)
+            ((double)(last - first) * (part + 1) / parts);
+         numTasks++;
+      }
+      bounds[pair / 2] = first;
+   }
+   bounds[(numRuns + 1) / 2] = total;
+
+   runTasks(mergeRange, (char *)tasks, sizeof(MergeTask), numTasks);
+   free(tasks);
+   return (numRuns + 1) / 2;
+}
+
+void parallelSortHTEntries(HTEntry *entries, unsigned numberOfEntries,
+   int numThreads)
+{
+   unsigned i, numRuns;
+   unsigned *bounds;
+   SortTask *runs;
+   HTEntry *scratch, *src, *dst, *swap;
+
+   numThreads = MIN(numThreads, (int)(numberOfEntries / MIN_PER_THREAD));
+   if(numThreads <= 1) {
+      qsortHTEntries(entries, numberOfEntries);
+      return;
+   }
+
+   numRuns = numThreads;
+   MY_MALLOC(bounds, (numRuns + 1) * sizeof(unsigned));
+   MY_MALLOC(runs, numRuns * sizeof(SortTask));
+   for(i = 0; i <= numRuns; i++)
+      bounds[i] = (unsigned)((double)numberOfEntries * i / numRuns);
+   for(i = 0; i < numRuns; i++) {
+      runs[i].entries = entries + bounds[i];
+      runs[i].count = bounds[i + 1] - bounds[i];
+   }
+   runTasks(sortRun, (char *)runs, sizeof(SortTask), numRuns);
+   free(runs);
+
+   MY_MALLOC_COUNTED(scratch, numberOfEntries * sizeof(HTEntry),
+      MEM_RESULTS);
+   src = entries;
+   dst = scratch;
+   while(numRuns > 1) {
+      numRuns = mergeRound(src, dst, bounds, numRuns, numThreads);
+      swap = src;
+      src = dst;
+      dst = swap;
+   }
+
+   if(src != entries)
+      memcpy(entries, src, numberOfEntries * sizeof(HTEntry));
+   free(scratch);
+   memFreed(MEM_RESULTS, numberOfEntries * sizeof(HTEntry));
+   free(bounds);
+}
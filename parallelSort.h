@@ -0,0 +1,30 @@
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+
+#include "hashTable.h"
+
+/* Description: Sorts the entries into exactly the order qsortHTEntries
+ *    produces (compareEntry: highest frequency first, ties by compareWord)
+ *    using up to numThreads threads.
+ *
+ * Notes:
+ *    1. The array is cut into one run per thread and each run is sorted with
+ *       qsort on its own thread. The runs are then merged pairwise, and every
+ *       merge is itself split into independent output ranges (found by binary
+ *       search) so all threads stay busy down to the last merge.
+ *    2. A scratch array of the same size as entries is allocated while
+ *       merging.
+ *    3. With one thread, or too few entries to be worth it, this is just
+ *       qsortHTEntries.
+ *
+ * Parameters:
+ *    entries: The array returned by htToArray (or an equivalent).
+ *    numberOfEntries: The number of entries in the array.
+ *    numThreads: The number of threads to use, 1 or more.
+ *
+ * Return: None
+ */
+void parallelSortHTEntries(HTEntry *entries, unsigned numberOfEntries,
+   int numThreads);
+
+#endif
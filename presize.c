@@ -0,0 +1,218 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "presize.h"
+#include "getWord.h"
+#include "ngram.h"
+#include "myMacros.h"
+
+/* The sample: this many blocks of this size, spread over all the files. */
+#define SAMPLE_BLOCKS 32
+#define SAMPLE_BLOCK (32 * 1024)
+#define SAMPLE_BYTES (SAMPLE_BLOCKS * SAMPLE_BLOCK)
+
+typedef struct {
+   int fd;
+   off_t size;
+} SampleFile;
+
+/* The distinct hashes seen so far, by linear probing. 0 marks an empty
+ * slot, so a hash of 0 is stored as 1. Two different words sharing a hash
+ * only cost the estimate one word.
+ */
+typedef struct {
+   unsigned *slots;
+   unsigned mask;
+   unsigned distinct;
+   unsigned tokens;
+} HashSet;
+
+/* Reused by every block: the bytes read, and their lowercase form. */
+typedef struct {
+   Byte *buffer;
+   Byte *lower;
+   NGram *ngram;
+   HashSet set;
+} Sampler;
+
+static void insertHash(HashSet *set, unsigned hash)
+{
+   unsigned i;
+
+   if(hash == 0)
+      hash = 1;
+   set->tokens++;
+   for(i = hash & set->mask; set->slots[i] != 0; i = (i + 1) & set->mask)
+      if(set->slots[i] == hash)
+         return;
+   set->slots[i] = hash;
+   set->distinct++;
+}
+
+static void countToken(Sampler *sampler, Byte *bytes, unsigned length)
+{
+   Word word;
+   Byte *joined;
+   unsigned joinedLength, hash;
+
+   if(sampler->ngram == NULL) {
+      word.bytes = bytes;
+      word.length = length;
+      insertHash(&sampler->set, hashWord(&word));
+   }
+   else if(ngramPush(sampler->ngram, bytes, length, &joined, &joinedLength,
+      &hash))
+      insertHash(&sampler->set, hash);
+}
+
+/* Counts the words of length bytes at offset. A word cut by either end of
+ * the block is left out, so the byte before and the byte after are read
+ * too.
+ */
+static void sampleBlock(Sampler *sampler, SampleFile *file, off_t offset,
+   size_t length)
+{
+   off_t readStart = offset > 0 ? offset - 1 : 0;
+   off_t readEnd = MIN(offset + (off_t)length + 1, file->size);
+   ssize_t got = pread(file->fd, sampler->buffer, readEnd - readStart,
+      readStart);
+   Byte *cursor, *end, *word;
+   unsigned wordLength, i;
+   int hasPrintable, hasUpper;
+
+   if(got <= 0)
+      return;
+
+   cursor = sampler->buffer + (offset - readStart);
+   end = sampler->buffer + MIN(offset + (off_t)length - readStart, got);
+   if(offset > 0 && !isspace(sampler->buffer[0]))
+      while(cursor < end && !isspace(*cursor))
+         cursor++;
+   if(end < sampler->buffer + got && !isspace(*end))
+      while(end > cursor && !isspace(end[-1]))
+         end--;
+
+   if(sampler->ngram != NULL)
+      ngramReset(sampler->ngram);
+
+   while(EOF != getWordSpan(&cursor, end, &word, &wordLength, &hasPrintable,
+      &hasUpper)) {
+      if(!hasPrintable)
+         continue;
+      if(hasUpper) {
+         for(i = 0; i < wordLength; i++)
+            sampler->lower[i] = tolower(word[i]);
+         word = sampler->lower;
+      }
+      countToken(sampler, word, wordLength);
+   }
+}
+
+/* Opens the regular, uncompressed, non-empty files. Returns their count. */
+static int openFiles(char *paths[], int numPaths, SampleFile *files,
+   double *total)
+{
+   int i, numFiles = 0;
+   struct stat status;
+   Byte magic[2];
+
+   *total = 0;
+   for(i = 0; i < numPaths; i++) {
+      if(0 > (files[numFiles].fd = open(paths[i], O_RDONLY)))
+         continue;
+      if(0 == fstat(files[numFiles].fd, &status) && S_ISREG(status.st_mode)
+         && status.st_size > 0
+         && !(2 == pread(files[numFiles].fd, magic, 2, 0)
+            && magic[0] == 0x1f && magic[1] == 0x8b)) {
+         files[numFiles].size = status.st_size;
+         *total += status.st_size;
+         numFiles++;
+      }
+      else
+         close(files[numFiles].fd);
+   }
+   return numFiles;
+}
+
+/* Samples block i of SAMPLE_BLOCKS evenly spaced blocks, the first at the
+ * start of the input and the last at its end, as if the files were one.
+ */
+static void sampleSpaced(Sampler *sampler, SampleFile *files, int numFiles,
+   double total, int i)
+{
+   double position = (total - SAMPLE_BLOCK) * i / (SAMPLE_BLOCKS - 1);
+   int f = 0;
+
+   while(f < numFiles - 1 && position >= files[f].size) {
+      position -= files[f].size;
+      f++;
+   }
+   sampleBlock(sampler, &files[f], (off_t)position,
+      MIN(SAMPLE_BLOCK, files[f].size - (off_t)position));
+}
+
+unsigned estimateUnique(char *paths[], int numPaths, int ngram)
+{
+   SampleFile *files;
+   Sampler sampler;
+   int i, numFiles;
+   double total, estimate, exponent;
+   unsigned halfDistinct, halfTokens, slots = 1;
+
+   MY_MALLOC(files, (numPaths + 1) * sizeof(SampleFile));
+   if(0 == (numFiles = openFiles(paths, numPaths, files, &total))) {
+      free(files);
+      return 0;
+   }
+
+   /* a word takes at least two bytes with its separator */
+   while(slots < SAMPLE_BYTES + 2)
+      slots <<= 1;
+   MY_CALLOC(sampler.set.slots, slots, unsigned);
+   sampler.set.mask = slots - 1;
+   sampler.set.distinct = sampler.set.tokens = 0;
+   MY_MALLOC(sampler.buffer, SAMPLE_BYTES + 2);
+   MY_MALLOC(sampler.lower, SAMPLE_BYTES + 2);
+   sampler.ngram = ngram > 0 ? ngramCreate(ngram) : NULL;
+
+   if(total <= SAMPLE_BYTES) {
+      for(i = 0; i < numFiles; i++)
+         sampleBlock(&sampler, &files[i], 0, files[i].size);
+      estimate = sampler.set.distinct;
+   }
+   else {
+      /* the even blocks are a sample of their own, half the size */
+      for(i = 0; i < SAMPLE_BLOCKS; i += 2)
+         sampleSpaced(&sampler, files, numFiles, total, i);
+      halfDistinct = sampler.set.distinct;
+      halfTokens = sampler.set.tokens;
+      for(i = 1; i < SAMPLE_BLOCKS; i += 2)
+         sampleSpaced(&sampler, files, numFiles, total, i);
+
+      /* Heaps' law: distinct = K * tokens^exponent */
+      exponent = 1;
+      if(halfDistinct > 0 && sampler.set.tokens > halfTokens)
+         exponent = log((double)sampler.set.distinct / halfDistinct)
+            / log((double)sampler.set.tokens / halfTokens);
+      exponent = MAX(0.0, MIN(1.0, exponent));
+      estimate = sampler.set.distinct
+         * pow(total / SAMPLE_BYTES, exponent);
+   }
+
+   for(i = 0; i < numFiles; i++)
+      close(files[i].fd);
+   if(sampler.ngram != NULL)
+      ngramDestroy(sampler.ngram);
+   free(sampler.set.slots);
+   free(sampler.buffer);
+   free(sampler.lower);
+   free(files);
+
+   return (unsigned)MIN(estimate, 4294967295.0);
+}
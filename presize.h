@@ -0,0 +1,27 @@
+#ifndef PRESIZE_H
+#define PRESIZE_H
+
+/* Estimating the vocabulary of the input before counting it, for --presize.
+ *
+ * A few evenly spaced blocks of the input files are read (wherever their
+ * sizes from stat put them) and their words counted as wf would, minus UTF-8
+ * folding and stopwords. Vocabulary grows with text length roughly as a
+ * power law (Heaps' law), so the distinct count of half of the blocks and
+ * of all of them give the exponent, which extrapolates the sample's
+ * distinct count to the whole input. Small inputs are read completely and
+ * their distinct count is exact.
+ */
+
+/* Description: Estimates the number of distinct words, or n-grams, in the
+ *    files.
+ *
+ * Parameters:
+ *    paths, numPaths: The input files. Those that cannot be opened, are not
+ *       regular files or are gzip compressed are left out.
+ *    ngram: K for --ngram K, 0 to count words.
+ *
+ * Return: The estimate, 0 when there was nothing to sample.
+ */
+unsigned estimateUnique(char *paths[], int numPaths, int ngram);
+
+#endif
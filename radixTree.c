@@ -0,0 +1,720 @@
+#include <string.h>
+#include <assert.h>
+#include "radixTree.h"
+#include "region.h"
+#include "myMacros.h"
+
+/*
+ * {{{ Structures -
+ *
+ * Every node starts with an RTNode so the type can be checked before the
+ * pointer is cast. Everything comes from the tree's region: a leaf holds
+ * its count and its Word, with the word's bytes right behind it, so
+ * comparing a key costs one cache miss, not three. A word that ends exactly
+ * at an inner node is kept in that node's terminal slot.
+ *
+ * Inner nodes keep the length of their compressed prefix and its first
+ * PREFIX_INLINE bytes. The rest is read from any leaf below the node when
+ * needed, since every word below shares the prefix; word stems are rarely
+ * longer, so that is seldom.
+ *
+ * NODE4 and NODE16 keep their keys sorted, NODE48 maps a byte to one of its
+ * child slots (0 meaning empty) and NODE256 indexes its children directly.
+ * A node outgrown by a larger one goes on a free list of its type for the
+ * next node of that type, since region memory is only freed all at once.
+ * }}}
+ */
+#define LEAF    0
+#define NODE4   1
+#define NODE16  2
+#define NODE48  3
+#define NODE256 4
+
+#define PREFIX_INLINE 8
+
+/* Words walked down together by rtAddBatch. */
+#define RT_BATCH 32
+
+#ifdef __GNUC__
+#define RT_PREFETCH(ADDRESS) __builtin_prefetch(ADDRESS)
+#else
+#define RT_PREFETCH(ADDRESS) ((void)0)
+#endif
+
+typedef struct {
+   Byte type;
+} RTNode;
+
+typedef struct {
+   RTNode header;
+   unsigned frequency;
+   Word word;
+} RTLeaf;
+
+typedef struct {
+   RTNode header;
+   unsigned short numChildren;
+   unsigned prefixLength;
+   Byte inlinePrefix[PREFIX_INLINE];
+   RTLeaf *terminal;
+} RTInner;
+
+typedef struct {
+   RTInner inner;
+   Byte keys[4];
+   RTNode *children[4];
+} RTNode4;
+
+typedef struct {
+   RTInner inner;
+   Byte keys[16];
+   RTNode *children[16];
+} RTNode16;
+
+typedef struct {
+   RTInner inner;
+   Byte index[256];
+   RTNode *children[48];
+} RTNode48;
+
+typedef struct {
+   RTInner inner;
+   RTNode *children[256];
+} RTNode256;
+
+typedef struct FreeNode {
+   struct FreeNode *next;
+} FreeNode;
+
+typedef struct {
+   RTNode *root;
+   Region *region;
+   FreeNode *freeNodes[NODE256 + 1];
+   unsigned totalEntries;
+   unsigned uniqueEntries;
+} RadixTree;
+
+/*
+ *{{{ Helper Declarations
+ */
+static RTLeaf *createLeaf(RadixTree *, Word *);
+static RTInner *createInner(RadixTree *, Byte, const Byte *, unsigned);
+static RTNode **findChild(RTInner *, Byte);
+static void addChild(RadixTree *, RTNode **, Byte, RTNode *);
+static void placeWord(RadixTree *, RTInner *, Word *, unsigned, RTLeaf *);
+static RTNode *splitLeaf(RadixTree *, RTLeaf *, Word *, unsigned);
+static RTNode *splitPrefix(RadixTree *, RTInner *, Word *, unsigned,
+   unsigned);
+static unsigned prefixMismatch(RTInner *, const Byte *, unsigned, unsigned);
+static void visitNode(RTNode *, FNVisit, void *);
+/* }}}
+ */
+
+void *rtCreate(void)
+{
+   RadixTree *rt;
+   MY_CALLOC(rt, 1, RadixTree);
+   rt->region = regionCreate();
+   return rt;
+}
+
+static RTLeaf *createLeaf(RadixTree *rt, Word *word)
+{
+   RTLeaf *leaf = regionAlloc(rt->region, sizeof(RTLeaf) + word->length);
+
+   memCount(MEM_NODES, sizeof(RTLeaf));
+   memCount(MEM_KEYS, word->length);
+   leaf->header.type = LEAF;
+   leaf->frequency = 1;
+   leaf->word.bytes = (Byte *)(leaf + 1);
+   leaf->word.length = word->length;
+   leaf->word.borrowed = 0;
+   memcpy(leaf->word.bytes, word->bytes, word->length);
+   return leaf;
+}
+
+static HTEntry leafEntry(RTLeaf *leaf)
+{
+   HTEntry entry;
+
+   entry.data = &leaf->word;
+   entry.frequency = leaf->frequency;
+   return entry;
+}
+
+static void setPrefix(RTInner *inner, const Byte *prefix, unsigned length)
+{
+   inner->prefixLength = length;
+   /* the prefix may be the node's own inline bytes, moved forward */
+   memmove(inner->inlinePrefix, prefix, MIN(length, PREFIX_INLINE));
+}
+
+static size_t innerSize(Byte type)
+{
+   switch(type) {
+      case NODE4:   return sizeof(RTNode4);
+      case NODE16:  return sizeof(RTNode16);
+      case NODE48:  return sizeof(RTNode48);
+      default:      return sizeof(RTNode256);
+   }
+}
+
+static RTInner *createInner(RadixTree *rt, Byte type, const Byte *prefix,
+   unsigned length)
+{
+   size_t size = innerSize(type);
+   RTInner *inner = (RTInner *)rt->freeNodes[type];
+
+   if(inner != NULL)
+      rt->freeNodes[type] = rt->freeNodes[type]->next;
+   else {
+      inner = regionAlloc(rt->region, size);
+      memCount(MEM_NODES, size);
+   }
+   memset(inner, 0, size);
+   inner->header.type = type;
+   setPrefix(inner, prefix, length);
+   return inner;
+}
+
+static void freeInner(RadixTree *rt, RTInner *inner)
+{
+   FreeNode *node = (FreeNode *)inner;
+   Byte type = inner->header.type;
+
+   node->next = rt->freeNodes[type];
+   rt->freeNodes[type] = node;
+}
+
+/* Returns a leaf below the node. Every word below an inner node starts with
+ * the same bytes up to the end of the node's prefix.
+ */
+static RTLeaf *anyLeaf(RTNode *node)
+{
+   RTInner *inner;
+   int i;
+
+   while(node->type != LEAF) {
+      inner = (RTInner *)node;
+      if(inner->terminal != NULL)
+         return inner->terminal;
+      switch(node->type) {
+         case NODE4:  node = ((RTNode4 *)node)->children[0];  break;
+         case NODE16: node = ((RTNode16 *)node)->children[0]; break;
+         case NODE48: node = ((RTNode48 *)node)->children[0]; break;
+         default:
+            for(i = 0; ((RTNode256 *)node)->children[i] == NULL; i++)
+               ;
+            node = ((RTNode256 *)node)->children[i];
+            break;
+      }
+   }
+   return (RTLeaf *)node;
+}
+
+/* Returns the prefix of inner, which starts depth bytes into the words. */
+static const Byte *prefixBytes(RTInner *inner, unsigned depth)
+{
+   if(inner->prefixLength <= PREFIX_INLINE)
+      return inner->inlinePrefix;
+   return anyLeaf((RTNode *)inner)->word.bytes + depth;
+}
+
+static RTNode **findChild(RTInner *inner, Byte key)
+{
+   int i;
+   RTNode4 *n4 = (RTNode4 *)inner;
+   RTNode16 *n16 = (RTNode16 *)inner;
+   RTNode48 *n48 = (RTNode48 *)inner;
+
+   switch(inner->header.type) {
+      case NODE4:
+         for(i = 0; i < inner->numChildren && n4->keys[i] <= key; i++)
+            if(n4->keys[i] == key)
+               return &n4->children[i];
+         return NULL;
+      case NODE16:
+         for(i = 0; i < inner->numChildren && n16->keys[i] <= key; i++)
+            if(n16->keys[i] == key)
+               return &n16->children[i];
+         return NULL;
+      case NODE48:
+         if(n48->index[key] == 0)
+            return NULL;
+         return &n48->children[n48->index[key] - 1];
+      default:
+         if(((RTNode256 *)inner)->children[key] == NULL)
+            return NULL;
+         return &((RTNode256 *)inner)->children[key];
+   }
+}
+
+/* Copies the shared inner fields when a node is replaced by a larger one.
+ */
+static RTInner *growInner(RadixTree *rt, RTInner *old, Byte type)
+{
+   RTInner *grown = createInner(rt, type, old->inlinePrefix,
+      old->prefixLength);
+   grown->numChildren = old->numChildren;
+   grown->terminal = old->terminal;
+   return grown;
+}
+
+static void insertSorted(Byte *keys, RTNode **children, int count, Byte key,
+   RTNode *child)
+{
+   int i = 0;
+
+   while(i < count && keys[i] < key)
+      i++;
+   memmove(keys + i + 1, keys + i, count - i);
+   memmove(children + i + 1, children + i, (count - i) * sizeof(RTNode *));
+   keys[i] = key;
+   children[i] = child;
+}
+
+/* Adds the child under key, replacing *ref with a larger node when the
+ * current one is full.
+ */
+static void addChild(RadixTree *rt, RTNode **ref, Byte key, RTNode *child)
+{
+   int i;
+   RTInner *inner = (RTInner *)*ref;
+   RTInner *grown;
+
+   switch(inner->header.type) {
+      case NODE4: {
+         RTNode4 *n4 = (RTNode4 *)inner;
+         if(inner->numChildren < 4) {
+            insertSorted(n4->keys, n4->children, inner->numChildren++, key,
+               child);
+            return;
+         }
+         grown = growInner(rt, inner, NODE16);
+         memcpy(((RTNode16 *)grown)->keys, n4->keys, 4);
+         memcpy(((RTNode16 *)grown)->children, n4->children,
+            4 * sizeof(RTNode *));
+         break;
+      }
+      case NODE16: {
+         RTNode16 *n16 = (RTNode16 *)inner;
+         if(inner->numChildren < 16) {
+            insertSorted(n16->keys, n16->children, inner->numChildren++, key,
+               child);
+            return;
+         }
+         grown = growInner(rt, inner, NODE48);
+         for(i = 0; i < 16; i++) {
+            ((RTNode48 *)grown)->index[n16->keys[i]] = i + 1;
+            ((RTNode48 *)grown)->children[i] = n16->children[i];
+         }
+         break;
+      }
+      case NODE48: {
+         RTNode48 *n48 = (RTNode48 *)inner;
+         if(inner->numChildren < 48) {
+            n48->children[inner->numChildren] = child;
+            n48->index[key] = ++inner->numChildren;
+            return;
+         }
+         grown = growInner(rt, inner, NODE256);
+         for(i = 0; i < 256; i++)
+            if(n48->index[i])
+               ((RTNode256 *)grown)->children[i] =
+                  n48->children[n48->index[i] - 1];
+         break;
+      }
+      default:
+         ((RTNode256 *)inner)->children[key] = child;
+         inner->numChildren++;
+         return;
+   }
+
+   freeInner(rt, inner);
+   *ref = (RTNode *)grown;
+   addChild(rt, ref, key, child);
+}
+
+/* Stores the leaf in a fresh inner node at the position the word ends up
+ * after depth bytes.
+ */
+static void placeWord(RadixTree *rt, RTInner *inner, Word *word,
+   unsigned depth, RTLeaf *leaf)
+{
+   RTNode *node = (RTNode *)inner;
+
+   if(word->length == depth)
+      inner->terminal = leaf;
+   else
+      addChild(rt, &node, word->bytes[depth], (RTNode *)leaf);
+}
+
+/* Replaces a leaf with a NODE4 holding both the leaf and the new word. Both
+ * words are known to match up to depth.
+ */
+static RTNode *splitLeaf(RadixTree *rt, RTLeaf *leaf, Word *word,
+   unsigned depth)
+{
+   Word *old = &leaf->word;
+   unsigned common = 0;
+   RTInner *inner;
+
+   while(depth + common < old->length && depth + common < word->length
+      && old->bytes[depth + common] == word->bytes[depth + common])
+      common++;
+
+   inner = createInner(rt, NODE4, old->bytes + depth, common);
+   placeWord(rt, inner, old, depth + common, leaf);
+   placeWord(rt, inner, word, depth + common, createLeaf(rt, word));
+   return (RTNode *)inner;
+}
+
+/* Splits the compressed prefix of inner at mismatch, which is where the new
+ * word diverges from it.
+ */
+static RTNode *splitPrefix(RadixTree *rt, RTInner *inner, Word *word,
+   unsigned depth, unsigned mismatch)
+{
+   const Byte *prefix = prefixBytes(inner, depth);
+   RTInner *parent = createInner(rt, NODE4, prefix, mismatch);
+   RTNode *node = (RTNode *)parent;
+   Byte edge = prefix[mismatch];
+
+   setPrefix(inner, prefix + mismatch + 1,
+      inner->prefixLength - mismatch - 1);
+   addChild(rt, &node, edge, (RTNode *)inner);
+   placeWord(rt, parent, word, depth + mismatch, createLeaf(rt, word));
+   return node;
+}
+
+/* Returns the number of prefix bytes of inner that match key from depth.
+ */
+static unsigned prefixMismatch(RTInner *inner, const Byte *key,
+   unsigned length, unsigned depth)
+{
+   unsigned i;
+   unsigned inlined = MIN(inner->prefixLength, PREFIX_INLINE);
+   const Byte *prefix;
+
+   for(i = 0; i < inlined; i++)
+      if(depth + i >= length || inner->inlinePrefix[i] != key[depth + i])
+         return i;
+   if(inner->prefixLength > PREFIX_INLINE) {
+      prefix = prefixBytes(inner, depth);
+      for(; i < inner->prefixLength; i++)
+         if(depth + i >= length || prefix[i] != key[depth + i])
+            return i;
+   }
+   return inner->prefixLength;
+}
+
+static int sameWord(Word *w1, Word *w2, unsigned depth)
+{
+   return w1->length == w2->length
+      && 0 == memcmp(w1->bytes + depth, w2->bytes + depth,
+         w1->length - depth);
+}
+
+unsigned rtAdd(void *tree, Word *word)
+{
+   RadixTree *rt = (RadixTree *)tree;
+   RTNode **ref = &rt->root;
+   RTNode **child;
+   RTInner *inner;
+   unsigned depth = 0;
+   unsigned mismatch;
+
+   assert(word != NULL);
+   rt->totalEntries++;
+
+   while(*ref != NULL) {
+      if((*ref)->type == LEAF) {
+         RTLeaf *leaf = (RTLeaf *)*ref;
+         if(sameWord(&leaf->word, word, depth))
+            return ++leaf->frequency;
+         *ref = splitLeaf(rt, leaf, word, depth);
+         rt->uniqueEntries++;
+         return 1;
+      }
+
+      inner = (RTInner *)*ref;
+      mismatch = prefixMismatch(inner, word->bytes, word->length, depth);
+      if(mismatch < inner->prefixLength) {
+         *ref = splitPrefix(rt, inner, word, depth, mismatch);
+         rt->uniqueEntries++;
+         return 1;
+      }
+
+      depth += inner->prefixLength;
+      if(depth == word->length) {
+         if(inner->terminal != NULL)
+            return ++inner->terminal->frequency;
+         inner->terminal = createLeaf(rt, word);
+         rt->uniqueEntries++;
+         return 1;
+      }
+
+      if(NULL == (child = findChild(inner, word->bytes[depth]))) {
+         addChild(rt, ref, word->bytes[depth], (RTNode *)createLeaf(rt, word));
+         rt->uniqueEntries++;
+         return 1;
+      }
+      ref = child;
+      depth++;
+   }
+
+   *ref = (RTNode *)createLeaf(rt, word);
+   rt->uniqueEntries++;
+   return 1;
+}
+
+/* Prefetches the first three cache lines of a node: all of a NODE4 or a
+ * NODE16 and, in a NODE48, the index entries of the letters.
+ */
+static void prefetchNode(RTNode *node)
+{
+   RT_PREFETCH(node);
+   RT_PREFETCH((char *)node + 64);
+   RT_PREFETCH((char *)node + 128);
+}
+
+/* Takes a step down for the word of a batch: returns the node below node
+ * to go on with, prefetched, or NULL when the walk is over. Then the word
+ * was found and counted, with *frequency set, or it is new and *frequency
+ * is 0. The tree is not changed other than by counting.
+ */
+static RTNode *stepDown(RadixTree *rt, RTNode *node, Word *word,
+   unsigned *depth, unsigned *frequency)
+{
+   RTInner *inner = (RTInner *)node;
+   RTLeaf *leaf = NULL;
+   RTNode **child;
+
+   *frequency = 0;
+   if(node == NULL)
+      return NULL;
+
+   if(node->type == LEAF)
+      leaf = (RTLeaf *)node;
+   else if(prefixMismatch(inner, word->bytes, word->length, *depth)
+      < inner->prefixLength)
+      return NULL;
+   else {
+      *depth += inner->prefixLength;
+      if(*depth == word->length)
+         leaf = inner->terminal;
+      else {
+         child = findChild(inner, word->bytes[*depth]);
+         if(child == NULL)
+            return NULL;
+         (*depth)++;
+         prefetchNode(*child);
+         return *child;
+      }
+   }
+
+   if(leaf != NULL && sameWord(&leaf->word, word, *depth)) {
+      *frequency = ++leaf->frequency;
+      rt->totalEntries++;
+   }
+   return NULL;
+}
+
+void rtAddBatch(void *tree, Word *words[], unsigned n, unsigned freqs[])
+{
+   RadixTree *rt = (RadixTree *)tree;
+   RTNode *nodes[RT_BATCH];
+   unsigned depths[RT_BATCH];
+   unsigned walkers[RT_BATCH];
+   unsigned start, size, i, k, w, numWalkers;
+
+   for(start = 0; start < n; start += size) {
+      size = MIN(RT_BATCH, n - start);
+
+      /* walk all the words down together, one level per round, so each
+       * round's nodes are prefetched while the others are walked
+       */
+      for(i = 0; i < size; i++) {
+         nodes[i] = rt->root;
+         depths[i] = 0;
+         walkers[i] = i;
+      }
+      for(numWalkers = size; numWalkers > 0; numWalkers = w)
+         for(i = 0, w = 0; i < numWalkers; i++) {
+            k = walkers[i];
+            nodes[k] = stepDown(rt, nodes[k], words[start + k], &depths[k],
+               &freqs[start + k]);
+            if(nodes[k] != NULL)
+               walkers[w++] = k;
+         }
+
+      /* the new words change the tree, so they go in one at a time */
+      for(i = start; i < start + size; i++)
+         if(freqs[i] == 0)
+            freqs[i] = rtAdd(rt, words[i]);
+   }
+}
+
+HTEntry rtLookUp(void *tree, Word *word)
+{
+   RTNode *node = ((RadixTree *)tree)->root;
+   RTNode **child;
+   RTInner *inner;
+   unsigned depth = 0;
+   HTEntry entry;
+
+   entry.data = NULL;
+   entry.frequency = 0;
+
+   assert(word != NULL);
+
+   while(node != NULL) {
+      if(node->type == LEAF) {
+         if(sameWord(&((RTLeaf *)node)->word, word, depth))
+            return leafEntry((RTLeaf *)node);
+         return entry;
+      }
+
+      inner = (RTInner *)node;
+      if(prefixMismatch(inner, word->bytes, word->length, depth)
+         < inner->prefixLength)
+         return entry;
+
+      depth += inner->prefixLength;
+      if(depth == word->length)
+         return inner->terminal ? leafEntry(inner->terminal) : entry;
+
+      if(NULL == (child = findChild(inner, word->bytes[depth])))
+         return entry;
+      node = *child;
+      depth++;
+   }
+   return entry;
+}
+
+static void visitNode(RTNode *node, FNVisit visit, void *context)
+{
+   int i;
+   RTInner *inner = (RTInner *)node;
+   HTEntry entry;
+
+   if(node->type == LEAF) {
+      entry = leafEntry((RTLeaf *)node);
+      visit(&entry, context);
+      return;
+   }
+
+   if(inner->terminal != NULL) {
+      entry = leafEntry(inner->terminal);
+      visit(&entry, context);
+   }
+
+   switch(node->type) {
+      case NODE4:
+         for(i = 0; i < inner->numChildren; i++)
+            visitNode(((RTNode4 *)node)->children[i], visit, context);
+         break;
+      case NODE16:
+         for(i = 0; i < inner->numChildren; i++)
+            visitNode(((RTNode16 *)node)->children[i], visit, context);
+         break;
+      case NODE48:
+         for(i = 0; i < 256; i++)
+            if(((RTNode48 *)node)->index[i])
+               visitNode(((RTNode48 *)node)->children[
+                  ((RTNode48 *)node)->index[i] - 1], visit, context);
+         break;
+      default:
+         for(i = 0; i < 256; i++)
+            if(((RTNode256 *)node)->children[i])
+               visitNode(((RTNode256 *)node)->children[i], visit, context);
+         break;
+   }
+}
+
+void rtIterate(void *tree, FNVisit visit, void *context)
+{
+   if(((RadixTree *)tree)->root != NULL)
+      visitNode(((RadixTree *)tree)->root, visit, context);
+}
+
+void rtIteratePrefix(void *tree, const Byte *prefix, unsigned length,
+   FNVisit visit, void *context)
+{
+   RTNode *node = ((RadixTree *)tree)->root;
+   RTNode **child;
+   RTInner *inner;
+   unsigned depth = 0;
+   Word *word;
+   HTEntry entry;
+
+   while(node != NULL) {
+      if(node->type == LEAF) {
+         word = &((RTLeaf *)node)->word;
+         if(word->length >= length
+            && 0 == memcmp(word->bytes + depth, prefix + depth,
+               length - depth)) {
+            entry = leafEntry((RTLeaf *)node);
+            visit(&entry, context);
+         }
+         return;
+      }
+
+      inner = (RTInner *)node;
+      if(depth + inner->prefixLength >= length) {
+         if(prefixMismatch(inner, prefix, length, depth) == length - depth)
+            visitNode(node, visit, context);
+         return;
+      }
+      if(prefixMismatch(inner, prefix, length, depth) < inner->prefixLength)
+         return;
+
+      depth += inner->prefixLength;
+      if(NULL == (child = findChild(inner, prefix[depth])))
+         return;
+      node = *child;
+      depth++;
+   }
+}
+
+static void collectEntry(HTEntry *entry, void *context)
+{
+   HTEntry **next = (HTEntry **)context;
+   *((*next)++) = *entry;
+}
+
+HTEntry *rtToArray(void *tree, unsigned *size)
+{
+   HTEntry *entryArray;
+   HTEntry *next;
+
+   *size = 0;
+   if(rtUniqueEntries(tree) == 0)
+      return NULL;
+
+   MY_MALLOC_COUNTED(entryArray, rtUniqueEntries(tree) * sizeof(HTEntry),
+      MEM_RESULTS);
+   next = entryArray;
+   rtIterate(tree, collectEntry, &next);
+
+   *size = next - entryArray;
+   return entryArray;
+}
+
+void rtDestroy(void *tree)
+{
+   RadixTree *rt = (RadixTree *)tree;
+
+   regionDestroy(rt->region);
+   free(rt);
+}
+
+unsigned rtUniqueEntries(void *tree)
+{
+   return ((RadixTree *)tree)->uniqueEntries;
+}
+
+unsigned rtTotalEntries(void *tree)
+{
+   return ((RadixTree *)tree)->totalEntries;
+}
@@ -0,0 +1,126 @@
+#ifndef RADIXTREE_H
+#define RADIXTREE_H
+
+#include "hashTable.h"
+#include "getWord.h"
+
+/* Adaptive radix tree keyed on the bytes of a Word.
+ *
+ * This is the ordered index behind -t, not the fast way to count: the hash
+ * table counts faster unless most words are new. Inner nodes grow from 4 to
+ * 16 to 48 to 256 children as needed and runs of bytes shared by every key
+ * below a node are collapsed into a single prefix, so common word stems are
+ * stored once. Because children are kept in byte order the entries can be
+ * visited in the same order compareWord sorts them without any sorting step,
+ * and a prefix is a subtree.
+ */
+
+/* Callback used by the iteration functions. The entry is only valid during
+ * the call; its data, the Word, points into the tree and must not be
+ * modified or freed.
+ */
+typedef void (*FNVisit)(HTEntry *entry, void *context);
+
+/* Description: Creates a new, empty radix tree.
+ *
+ * Return: A pointer to an anonymous structure representing the tree.
+ */
+void *rtCreate(void);
+
+/* Description: Frees the tree and every word in it, all at once.
+ *
+ * Parameters:
+ *    tree: A pointer returned by rtCreate.
+ *
+ * Return: None
+ */
+void rtDestroy(void *tree);
+
+/* Description: Counts the word. A new word is copied into the tree, bytes
+ *    included, so the word and its bytes stay the caller's either way.
+ *
+ * Notes:
+ *    1. The function has O(k) performance, k being the length of the word.
+ *    2. The function asserts (man 3 assert) if word is NULL.
+ *
+ * Parameters:
+ *    tree: A pointer returned by rtCreate.
+ *    word: The word to add.
+ *
+ * Return: The frequency of the word in the tree, 1 meaning new and unique.
+ */
+unsigned rtAdd(void *tree, Word *word);
+
+/* Description: Counts the n words in order, exactly like n calls to rtAdd,
+ *    and stores the frequency each call would have returned in freqs. The
+ *    words are walked down the tree together, a level at a time, with the
+ *    next level's nodes prefetched, so the cache misses of the batch
+ *    overlap instead of each word stalling on its own. Within a batch, a
+ *    word may equal an earlier one.
+ *
+ * Parameters:
+ *    tree: A pointer returned by rtCreate.
+ *    words: The words to count.
+ *    n: The number of words.
+ *    freqs: Output, n frequencies.
+ *
+ * Return: None
+ */
+void rtAddBatch(void *tree, Word *words[], unsigned n, unsigned freqs[]);
+
+/* Description: Determines if the word is in the tree or not.
+ *
+ * Parameters:
+ *    tree: A pointer returned by rtCreate.
+ *    word: The word to look for.
+ *
+ * Return: An HTEntry with a shallow copy of the word and its frequency if
+ *    found, otherwise NULL data and frequency 0.
+ */
+HTEntry rtLookUp(void *tree, Word *word);
+
+/* Description: Returns a dynamically allocated array with shallow copies of
+ *    all of the entries, already sorted by compareWord. Ownership rules are
+ *    the same as for htToArray.
+ *
+ * Parameters:
+ *    tree: A pointer returned by rtCreate.
+ *    size: Output parameter updated with the array's size.
+ *
+ * Return: The array, or NULL if the tree is empty.
+ */
+HTEntry *rtToArray(void *tree, unsigned *size);
+
+/* Description: Calls visit on every entry in compareWord order.
+ *
+ * Parameters:
+ *    tree: A pointer returned by rtCreate.
+ *    visit: Called once per entry.
+ *    context: Passed through to visit.
+ *
+ * Return: None
+ */
+void rtIterate(void *tree, FNVisit visit, void *context);
+
+/* Description: Calls visit, in compareWord order, on every entry whose word
+ *    starts with the given bytes. Only the subtree below the prefix is
+ *    walked.
+ *
+ * Parameters:
+ *    tree: A pointer returned by rtCreate.
+ *    prefix: The leading bytes to match, not nul-terminated.
+ *    length: The number of bytes in prefix, 0 visits every entry.
+ *    visit: Called once per matching entry.
+ *    context: Passed through to visit.
+ *
+ * Return: None
+ */
+void rtIteratePrefix(void *tree, const Byte *prefix, unsigned length,
+   FNVisit visit, void *context);
+
+/* Same meaning as htUniqueEntries and htTotalEntries. O(1).
+ */
+unsigned rtUniqueEntries(void *tree);
+unsigned rtTotalEntries(void *tree);
+
+#endif
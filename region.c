@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "region.h"
+#include "hugePages.h"
+#include "myMacros.h"
+
+#define CHUNK_SIZE (1 << 20)
+#define ALIGNMENT REGION_ALIGNMENT
+
+/* Allocations larger than a quarter chunk get a chunk of their own so the
+ * rest of the current chunk is not wasted.
+ */
+#define LARGE_ALLOC (CHUNK_SIZE / 4)
+
+typedef struct Chunk {
+   struct Chunk *next;
+   size_t size;
+   size_t used;
+} Chunk;
+
+/* The usable bytes of a chunk follow its header, which is padded out to a
+ * multiple of ALIGNMENT.
+ */
+#define HEADER_SIZE ((sizeof(Chunk) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+#define CHUNK_DATA(CHUNK) ((char *)(CHUNK) + HEADER_SIZE)
+
+/* With huge pages a chunk, header included, is exactly one. */
+#define REGULAR_CHUNK (hugePageMode == HUGE_PAGES_OFF ? CHUNK_SIZE \
+   : HUGE_PAGE_SIZE - HEADER_SIZE)
+
+struct Region {
+   Chunk *current;
+   Chunk *large;
+};
+
+Region *regionCreate(void)
+{
+   Region *region;
+   MY_CALLOC(region, 1, Region);
+   return region;
+}
+
+static Chunk *createChunk(size_t size, Chunk *next)
+{
+   Chunk *chunk = hugeAlloc(HEADER_SIZE + size, 0, MEM_REGION_SLACK);
+   chunk->next = next;
+   chunk->size = size;
+   chunk->used = 0;
+   return chunk;
+}
+
+void *regionAllocBytes(Region *region, size_t size)
+{
+   Chunk *chunk = region->current;
+   void *memory;
+
+   /* the caller counts it in its own category */
+   memCount(MEM_REGION_SLACK, -(long)size);
+
+   if(size > LARGE_ALLOC) {
+      region->large = createChunk(size, region->large);
+      return CHUNK_DATA(region->large);
+   }
+
+   if(chunk == NULL || chunk->size - chunk->used < size)
+      chunk = region->current = createChunk(REGULAR_CHUNK, region->current);
+
+   memory = CHUNK_DATA(chunk) + chunk->used;
+   chunk->used += size;
+   return memory;
+}
+
+void *regionAlloc(Region *region, size_t size)
+{
+   Chunk *chunk = region->current;
+
+   if(chunk != NULL)
+      chunk->used = (chunk->used + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+   return regionAllocBytes(region, (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1));
+}
+
+static void freeChunks(Chunk *chunk)
+{
+   Chunk *next;
+
+   while(chunk != NULL) {
+      next = chunk->next;
+      hugeFree(chunk, HEADER_SIZE + chunk->size, MEM_REGION_SLACK);
+      chunk = next;
+   }
+}
+
+void regionDestroy(Region *region)
+{
+   freeChunks(region->current);
+   freeChunks(region->large);
+   free(region);
+}
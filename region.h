@@ -0,0 +1,46 @@
+#ifndef REGION_H
+#define REGION_H
+
+#include <stddef.h>
+
+/* A region (arena) hands out memory from large chunks and frees it all at
+ * once. Nothing allocated from a region can be freed on its own.
+ */
+typedef struct Region Region;
+
+/* Every regionAlloc is aligned to REGION_ALIGNMENT, so the low bits of a
+ * pointer to one are always zero and may carry a tag from 0 to REGION_TAG_MAX
+ * while it is stored. The pointer goes through size_t to get at them, which
+ * the typedef below checks is wide enough.
+ */
+#define REGION_ALIGNMENT sizeof(void *)
+#define REGION_TAG_MAX (REGION_ALIGNMENT - 1)
+
+#define REGION_TAG(POINTER) \
+   ((unsigned)((size_t)(POINTER) & REGION_TAG_MAX))
+#define REGION_UNTAG(POINTER) \
+   ((void *)((size_t)(POINTER) & ~(size_t)REGION_TAG_MAX))
+#define REGION_TAGGED(POINTER, TAG) ((void *)((size_t)(POINTER) | (TAG)))
+
+typedef char regionPointerFitsSizeT[sizeof(size_t) >= sizeof(void *) ? 1 : -1];
+
+/* Description: Creates an empty region. Chunks are allocated as needed. */
+Region *regionCreate(void);
+
+/* Description: Returns size bytes aligned for any pointer or integer type.
+ *    Allocation failures are reported and the program exits, like
+ *    MY_MALLOC.
+ */
+void *regionAlloc(Region *region, size_t size);
+
+/* Description: Same as regionAlloc without the alignment, for byte strings.
+ */
+void *regionAllocBytes(Region *region, size_t size);
+
+/* Description: Frees every chunk, and with them everything allocated from
+ *    the region, and the region itself. The cost depends on the number of
+ *    chunks, not on the number of allocations.
+ */
+void regionDestroy(Region *region);
+
+#endif
@@ -0,0 +1,289 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
+#include "report.h"
+#include "getWord.h"
+#include "documents.h"
+#include "myMacros.h"
+
+#define REPORT_BUFFER (1 << 20)
+#define DISPLAY_WIDTH 30
+#define FREQ_WIDTH 10
+
+/* The widest expansion of one input byte (\u00HH in JSON).
+ */
+#define MAX_ESCAPE 6
+
+typedef struct {
+   int fd;
+   char *buffer;
+   unsigned used;
+} Writer;
+
+static const char hexDigits[] = "0123456789abcdef";
+
+static void flushWriter(Writer *writer)
+{
+   char *next = writer->buffer;
+   ssize_t written;
+
+   while(writer->used > 0) {
+      if(0 > (written = write(writer->fd, next, writer->used))) {
+         if(errno == EINTR)
+            continue;
+         perror(NULL);
+         exit(EXIT_FAILURE);
+      }
+      next += written;
+      writer->used -= written;
+   }
+}
+
+static void reserve(Writer *writer, unsigned size)
+{
+   if(writer->used + size > REPORT_BUFFER)
+      flushWriter(writer);
+}
+
+static void putBytes(Writer *writer, const char *bytes, unsigned length)
+{
+   reserve(writer, length);
+   memcpy(writer->buffer + writer->used, bytes, length);
+   writer->used += length;
+}
+
+/* Writes the number right aligned in width columns (0 for no padding).
+ */
+static void putUnsigned(Writer *writer, unsigned value, int width)
+{
+   char digits[16];
+   int i = sizeof(digits);
+
+   do {
+      digits[--i] = '0' + value % 10;
+      value /= 10;
+   } while(value != 0);
+
+   while((int)sizeof(digits) - i < width)
+      digits[--i] = ' ';
+
+   putBytes(writer, digits + i, sizeof(digits) - i);
+}
+
+static void putTextWord(Writer *writer, Word *word, const char *display)
+{
+   unsigned i;
+   unsigned length = MIN(word->length, DISPLAY_WIDTH);
+   char *out;
+
+   reserve(writer, DISPLAY_WIDTH + 4);
+   out = writer->buffer + writer->used;
+   for(i = 0; i < length; i++)
+      out[i] = display[word->bytes[i]];
+   if(word->length > DISPLAY_WIDTH) {
+      memcpy(out + i, "...", 3);
+      i += 3;
+   }
+   out[i++] = '\n';
+   writer->used += i;
+}
+
+static unsigned escapeTsv(Byte byte, char *out)
+{
+   switch(byte) {
+      case '\t': out[1] = 't'; break;
+      case '\n': out[1] = 'n'; break;
+      case '\r': out[1] = 'r'; break;
+      case '\\': out[1] = '\\'; break;
+      default:
+         if(isprint(byte)) {
+            out[0] = byte;
+            return 1;
+         }
+         out[0] = '\\';
+         out[1] = 'x';
+         out[2] = hexDigits[byte >> 4];
+         out[3] = hexDigits[byte & 0xf];
+         return 4;
+   }
+   out[0] = '\\';
+   return 2;
+}
+
+static unsigned escapeJson(Byte byte, char *out)
+{
+   if(byte == '"' || byte == '\\') {
+      out[0] = '\\';
+      out[1] = byte;
+      return 2;
+   }
+   if(byte >= 0x20 && byte < 0x7f) {
+      out[0] = byte;
+      return 1;
+   }
+   memcpy(out, "\\u00", 4);
+   out[4] = hexDigits[byte >> 4];
+   out[5] = hexDigits[byte & 0xf];
+   return 6;
+}
+
+static unsigned escapeCsv(Byte byte, char *out)
+{
+   out[0] = byte;
+   if(byte != '"')
+      return 1;
+   out[1] = '"';
+   return 2;
+}
+
+static int needsCsvQuotes(Word *word)
+{
+   unsigned i;
+
+   for(i = 0; i < word->length; i++)
+      if(word->bytes[i] == ',' || word->bytes[i] == '"'
+         || word->bytes[i] == '\n' || word->bytes[i] == '\r')
+         return 1;
+   return 0;
+}
+
+/* Writes every byte of the word through the escape function, in blocks that
+ * fit the buffer so words of any length can be written.
+ */
+static void putEscapedWord(Writer *writer, Word *word,
+   unsigned (*escape)(Byte, char *))
+{
+   unsigned i = 0, end;
+   unsigned block = REPORT_BUFFER / MAX_ESCAPE;
+
+   while(i < word->length) {
+      end = MIN(word->length, i + block);
+      reserve(writer, (end - i) * MAX_ESCAPE);
+      for(; i < end; i++)
+         writer->used += escape(word->bytes[i], writer->buffer + writer->used);
+   }
+}
+
+static void writeEntry(Writer *writer, ReportFormat format, HTEntry *entry,
+   int documents, const char *display)
+{
+   Word *word = (Word *)entry->data;
+
+   switch(format) {
+      case REPORT_TEXT:
+         putUnsigned(writer, entry->frequency, FREQ_WIDTH);
+         if(documents)
+            putUnsigned(writer, ((DocWord *)word)->documents, FREQ_WIDTH + 1);
+         putBytes(writer, " - ", 3);
+         putTextWord(writer, word, display);
+         break;
+      case REPORT_TSV:
+         putUnsigned(writer, entry->frequency, 0);
+         putBytes(writer, "\t", 1);
+         if(documents) {
+            putUnsigned(writer, ((DocWord *)word)->documents, 0);
+            putBytes(writer, "\t", 1);
+         }
+         putEscapedWord(writer, word, escapeTsv);
+         putBytes(writer, "\n", 1);
+         break;
+      case REPORT_CSV:
+         putUnsigned(writer, entry->frequency, 0);
+         if(documents) {
+            putBytes(writer, ",", 1);
+            putUnsigned(writer, ((DocWord *)word)->documents, 0);
+         }
+         if(needsCsvQuotes(word)) {
+            putBytes(writer, ",\"", 2);
+            putEscapedWord(writer, word, escapeCsv);
+            putBytes(writer, "\"\r\n", 3);
+         }
+         else {
+            putBytes(writer, ",", 1);
+            putEscapedWord(writer, word, escapeCsv);
+            putBytes(writer, "\r\n", 2);
+         }
+         break;
+      case REPORT_JSON:
+         putBytes(writer, "{\"word\":\"", 9);
+         putEscapedWord(writer, word, escapeJson);
+         putBytes(writer, "\",\"frequency\":", 14);
+         putUnsigned(writer, entry->frequency, 0);
+         if(documents) {
+            putBytes(writer, ",\"documents\":", 13);
+            putUnsigned(writer, ((DocWord *)word)->documents, 0);
+         }
+         putBytes(writer, "}\n", 2);
+         break;
+   }
+}
+
+int parseReportFormat(const char *name, ReportFormat *format)
+{
+   if(!strcmp(name, "text"))
+      *format = REPORT_TEXT;
+   else if(!strcmp(name, "tsv"))
+      *format = REPORT_TSV;
+   else if(!strcmp(name, "csv"))
+      *format = REPORT_CSV;
+   else if(!strcmp(name, "json"))
+      *format = REPORT_JSON;
+   else
+      return -1;
+   return 0;
+}
+
+void writeReport(int fd, ReportFormat format, unsigned uniqueWords,
+   unsigned totalWords, unsigned numDocuments, HTEntry *entries,
+   unsigned count)
+{
+   Writer writer;
+   char display[256];
+   unsigned i;
+
+   for(i = 0; i < 256; i++)
+      display[i] = isprint(i) ? i : '.';
+
+   writer.fd = fd;
+   writer.used = 0;
+   MY_MALLOC(writer.buffer, REPORT_BUFFER);
+
+   switch(format) {
+      case REPORT_TEXT:
+         putUnsigned(&writer, uniqueWords, 0);
+         putBytes(&writer, " unique words found in ", 23);
+         putUnsigned(&writer, totalWords, 0);
+         putBytes(&writer, " total words", 12);
+         if(numDocuments > 0) {
+            putBytes(&writer, " in ", 4);
+            putUnsigned(&writer, numDocuments, 0);
+            putBytes(&writer, " documents", 10);
+         }
+         putBytes(&writer, "\n", 1);
+         break;
+      case REPORT_TSV:
+         if(numDocuments > 0)
+            putBytes(&writer, "frequency\tdocuments\tword\n", 25);
+         else
+            putBytes(&writer, "frequency\tword\n", 15);
+         break;
+      case REPORT_CSV:
+         if(numDocuments > 0)
+            putBytes(&writer, "frequency,documents,word\r\n", 26);
+         else
+            putBytes(&writer, "frequency,word\r\n", 16);
+         break;
+      case REPORT_JSON:
+         break;
+   }
+
+   for(i = 0; i < count; i++)
+      writeEntry(&writer, format, &entries[i], numDocuments > 0, display);
+
+   flushWriter(&writer);
+   free(writer.buffer);
+}
@@ -0,0 +1,58 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "hashTable.h"
+
+/* Output formats for the word report.
+ *
+ *    REPORT_TEXT: The classic layout. A summary line, then one line per word
+ *       with the frequency right aligned in 10 columns, words cut to 30 bytes
+ *       (with "..." appended) and non-printable bytes shown as '.'.
+ *    REPORT_TSV:  "frequency<TAB>word" rows after a header row. Tab, newline,
+ *       carriage return and backslash are escaped as \t \n \r \\, any other
+ *       non-printable byte as \xHH.
+ *    REPORT_CSV:  "frequency,word" rows after a header row (RFC 4180). Words
+ *       containing a comma, quote, CR or LF are quoted, quotes doubled, other
+ *       bytes are written unchanged.
+ *    REPORT_JSON: One {"word":...,"frequency":...} object per line. Bytes
+ *       that are not printable ASCII are written as \u00HH, i.e. the word is
+ *       read as Latin-1, so every line is valid JSON even for binary input.
+ *
+ * The machine formats always write the complete word and no summary line.
+ */
+typedef enum {
+   REPORT_TEXT,
+   REPORT_TSV,
+   REPORT_CSV,
+   REPORT_JSON
+} ReportFormat;
+
+/* Description: Maps a format name (text, tsv, csv or json) to its value.
+ *
+ * Return: 0 on success, -1 if the name is not a known format.
+ */
+int parseReportFormat(const char *name, ReportFormat *format);
+
+/* Description: Writes the report for the first count entries to the file
+ *    descriptor. Output is formatted into a large buffer and handed to
+ *    write(2) in big blocks; no stdio calls are made per word or per byte.
+ *    Write errors are reported with perror and the program exits.
+ *
+ * Parameters:
+ *    fd: The descriptor to write to, e.g. STDOUT_FILENO.
+ *    format: The layout to use.
+ *    uniqueWords, totalWords: Used for the REPORT_TEXT summary line.
+ *    numDocuments: The documents counted with --doc-freq, 0 without. When
+ *       set, the data must be DocWord * and their document frequency is
+ *       written after the frequency (a "documents" column or field), and
+ *       the summary line ends with "in N documents".
+ *    entries: The entries to print, in order. The data must be Word *.
+ *    count: The number of entries to print.
+ *
+ * Return: None
+ */
+void writeReport(int fd, ReportFormat format, unsigned uniqueWords,
+   unsigned totalWords, unsigned numDocuments, HTEntry *entries,
+   unsigned count);
+
+#endif
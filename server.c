@@ -0,0 +1,315 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "myMacros.h"
+
+#define READ_SIZE 65536
+
+/* Longer request lines close the connection. */
+#define MAX_LINE 65536
+
+/* A client whose unsent responses pass this is not read from until it
+ * catches up.
+ */
+#define MAX_PENDING (1 << 20)
+
+typedef struct {
+   int fd;
+   Byte *in;
+   unsigned inUsed;
+   Byte *out;
+   unsigned outUsed;
+   unsigned outSize;
+   unsigned outSent;
+   int finished;
+} Client;
+
+static volatile sig_atomic_t stopping = 0;
+
+static void stopServing(int signal)
+{
+   stopping = 1;
+}
+
+static void fail(const char *what)
+{
+   perror(what);
+   exit(EXIT_FAILURE);
+}
+
+static void setNonBlocking(int fd)
+{
+   if(0 > fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK))
+      fail("fcntl");
+}
+
+static int listenOn(const char *path)
+{
+   struct sockaddr_un address;
+   struct stat info;
+   int fd;
+
+   if(strlen(path) >= sizeof(address.sun_path)) {
+      fprintf(stderr, "wf: %s: socket path too long\n", path);
+      exit(EXIT_FAILURE);
+   }
+   memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   strcpy(address.sun_path, path);
+
+   /* a socket left behind by an earlier run, never a regular file */
+   if(0 == stat(path, &info) && S_ISSOCK(info.st_mode))
+      unlink(path);
+
+   if(0 > (fd = socket(AF_UNIX, SOCK_STREAM, 0)))
+      fail("socket");
+   if(0 > bind(fd, (struct sockaddr *)&address, sizeof(address)))
+      fail(path);
+   if(0 > listen(fd, SOMAXCONN))
+      fail("listen");
+   setNonBlocking(fd);
+   return fd;
+}
+
+static void reserveOutput(Client *client, unsigned size)
+{
+   Byte *grown;
+
+   if(client->outUsed + size <= client->outSize)
+      return;
+   client->outSize = MAX(client->outUsed + size, 2 * client->outSize);
+   MY_MALLOC(grown, client->outSize);
+   if(client->outUsed > 0)
+      memcpy(grown, client->out, client->outUsed);
+   free(client->out);
+   client->out = grown;
+}
+
+static void putBytes(Client *client, const void *bytes, unsigned length)
+{
+   reserveOutput(client, length);
+   memcpy(client->out + client->outUsed, bytes, length);
+   client->outUsed += length;
+}
+
+static void putUnsigned(Client *client, unsigned value, char end)
+{
+   char text[16];
+
+   sprintf(text, "%u%c", value, end);
+   putBytes(client, text, strlen(text));
+}
+
+static void answerTop(Client *client, ServerData *data, unsigned n)
+{
+   unsigned i, frequency, length;
+   const Byte *bytes;
+
+   n = MIN(n, fwSize(data->words));
+   for(i = 0; i < n; i++) {
+      frequency = fwRanked(data->words, i, &bytes, &length);
+      putUnsigned(client, frequency, '\t');
+      putBytes(client, bytes, length);
+      putBytes(client, "\n", 1);
+   }
+   putBytes(client, "\n", 1);
+}
+
+static void answer(Client *client, ServerData *data, Byte *line,
+   unsigned length)
+{
+   char number[16];
+   unsigned n;
+
+   if(length > 4 && !memcmp(line, "GET ", 4))
+      putUnsigned(client, data->lookUp(line + 4, length - 4, data->context),
+         '\n');
+   else if(length > 4 && length < 4 + sizeof(number)
+      && !memcmp(line, "TOP ", 4)) {
+      memcpy(number, line + 4, length - 4);
+      number[length - 4] = '\0';
+      if(1 == sscanf(number, "%u", &n))
+         answerTop(client, data, n);
+      else
+         putBytes(client, "ERR\n", 4);
+   }
+   else if(length == 5 && !memcmp(line, "STATS", 5)) {
+      putUnsigned(client, data->uniqueWords, '\t');
+      putUnsigned(client, data->totalWords, '\n');
+   }
+   else
+      putBytes(client, "ERR\n", 4);
+}
+
+/* Answers every complete line in the input buffer. Returns -1 if the
+ * client sent a line that is too long.
+ */
+static int answerLines(Client *client, ServerData *data)
+{
+   Byte *line = client->in, *end = client->in + client->inUsed, *newline;
+   unsigned length;
+
+   while(NULL != (newline = memchr(line, '\n', end - line))) {
+      length = newline - line;
+      if(length > 0 && line[length - 1] == '\r')
+         length--;
+      answer(client, data, line, length);
+      line = newline + 1;
+   }
+
+   client->inUsed = end - line;
+   if(client->inUsed >= MAX_LINE)
+      return -1;
+   memmove(client->in, line, client->inUsed);
+   return 0;
+}
+
+/* Returns -1 when the client misbehaved. A client that has sent everything
+ * is marked finished, and an unterminated last line is answered too.
+ */
+static int readClient(Client *client, ServerData *data)
+{
+   ssize_t got;
+
+   while(client->outUsed - client->outSent < MAX_PENDING) {
+      got = read(client->fd, client->in + client->inUsed,
+         MAX_LINE + READ_SIZE - client->inUsed);
+      if(got == 0) {
+         if(client->inUsed > 0)
+            answer(client, data, client->in, client->inUsed);
+         client->inUsed = 0;
+         client->finished = 1;
+         return 0;
+      }
+      if(got < 0)
+         return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            ? 0 : -1;
+      client->inUsed += got;
+      if(0 > answerLines(client, data))
+         return -1;
+   }
+   return 0;
+}
+
+static int writeClient(Client *client)
+{
+   ssize_t sent;
+
+   while(client->outSent < client->outUsed) {
+      sent = write(client->fd, client->out + client->outSent,
+         client->outUsed - client->outSent);
+      if(sent < 0)
+         return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            ? 0 : -1;
+      client->outSent += sent;
+   }
+   client->outUsed = client->outSent = 0;
+   return 0;
+}
+
+static void closeClient(Client *client)
+{
+   close(client->fd);
+   free(client->in);
+   free(client->out);
+}
+
+static void acceptClients(int listener, Client **clients,
+   unsigned *numClients, unsigned *maxClients)
+{
+   int fd;
+   Client *client;
+
+   while(0 <= (fd = accept(listener, NULL, NULL))) {
+      setNonBlocking(fd);
+      if(*numClients == *maxClients) {
+         *maxClients = MAX(2 * *maxClients, 16);
+         *clients = realloc(*clients, *maxClients * sizeof(Client));
+         if(*clients == NULL)
+            fail(NULL);
+      }
+      client = &(*clients)[(*numClients)++];
+      memset(client, 0, sizeof(Client));
+      client->fd = fd;
+      MY_MALLOC(client->in, MAX_LINE + READ_SIZE);
+   }
+}
+
+void serveQueries(const char *path, ServerData *data)
+{
+   struct sigaction action;
+   struct pollfd *polls = NULL;
+   Client *clients = NULL;
+   unsigned i, numClients = 0, maxClients = 0, maxPolls = 0;
+   int listener, gone;
+
+   memset(&action, 0, sizeof(action));
+   action.sa_handler = stopServing;
+   sigaction(SIGINT, &action, NULL);
+   sigaction(SIGTERM, &action, NULL);
+   /* a client that hangs up early must not kill the server */
+   action.sa_handler = SIG_IGN;
+   sigaction(SIGPIPE, &action, NULL);
+
+   listener = listenOn(path);
+
+   while(!stopping) {
+      if(maxPolls < numClients + 1) {
+         maxPolls = MAX(numClients + 1, 2 * maxPolls);
+         free(polls);
+         MY_MALLOC(polls, maxPolls * sizeof(struct pollfd));
+      }
+      polls[0].fd = listener;
+      polls[0].events = POLLIN;
+      for(i = 0; i < numClients; i++) {
+         polls[i + 1].fd = clients[i].fd;
+         polls[i + 1].events = 0;
+         if(!clients[i].finished
+            && clients[i].outUsed - clients[i].outSent < MAX_PENDING)
+            polls[i + 1].events |= POLLIN;
+         if(clients[i].outSent < clients[i].outUsed)
+            polls[i + 1].events |= POLLOUT;
+      }
+
+      if(0 > poll(polls, numClients + 1, -1)) {
+         if(errno == EINTR)
+            continue;
+         fail("poll");
+      }
+
+      /* walk backwards so removing a client keeps the rest in place */
+      for(i = numClients; i-- > 0;) {
+         gone = (polls[i + 1].revents & (POLLERR | POLLNVAL)) != 0;
+         if(!gone && (polls[i + 1].revents & (POLLIN | POLLHUP)))
+            gone = readClient(&clients[i], data) < 0;
+         if(!gone)
+            gone = writeClient(&clients[i]) < 0
+               || (clients[i].finished && clients[i].outUsed == 0);
+         if(gone) {
+            closeClient(&clients[i]);
+            clients[i] = clients[--numClients];
+         }
+      }
+
+      if(polls[0].revents & POLLIN)
+         acceptClients(listener, &clients, &numClients, &maxClients);
+   }
+
+   for(i = 0; i < numClients; i++)
+      closeClient(&clients[i]);
+   free(clients);
+   free(polls);
+   close(listener);
+   unlink(path);
+}
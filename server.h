@@ -0,0 +1,49 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "getWord.h"
+#include "frozenWords.h"
+
+/* The --serve query daemon.
+ *
+ * After counting, the results stay resident, frozen into the compact
+ * layout of frozenWords.h, and are queried over a Unix domain stream
+ * socket with a line protocol. Every request is one line; a client may
+ * send any number of requests without waiting (pipelining) and gets the
+ * responses in order:
+ *
+ *    GET word     "<frequency>\n", 0 for a word that was not counted. The
+ *                 word is folded like the input words. With --ngram the
+ *                 request holds the K words of the n-gram.
+ *    TOP n        The n most frequent words as "<frequency>\t<word>\n"
+ *                 lines (words never contain whitespace), then "\n".
+ *    STATS        "<unique words>\t<total words>\n"
+ *
+ * Anything else is answered with "ERR\n". All clients are served by one
+ * thread with poll(): every query is an in-memory lookup, so there is
+ * nothing to wait for but the sockets.
+ */
+
+/* Answers a GET: the frequency of the query as the client sent it.
+ */
+typedef unsigned (*FNLookUp)(Byte *query, unsigned length, void *context);
+
+typedef struct {
+   FNLookUp lookUp;
+   void *context;
+   const FrozenWords *words;
+   unsigned uniqueWords;
+   unsigned totalWords;
+} ServerData;
+
+/* Description: Listens on the socket path (replacing a stale socket there)
+ *    and answers requests until SIGINT or SIGTERM, then removes the socket.
+ *    Setup errors are reported with perror and the program exits.
+ *
+ * Parameters:
+ *    path: The socket path.
+ *    data: What to serve. words must be ranked by frequency.
+ */
+void serveQueries(const char *path, ServerData *data);
+
+#endif
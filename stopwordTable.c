@@ -0,0 +1,273 @@
+/* Generated by tools/genStopwords.py from tools/stopwords.txt - do not edit.
+ */
+#include "stopwords.h"
+
+static const unsigned displacements[] = {
+   1, 1, 5, 0, 0, 0, 2, 2,
+   0, 7, 0, 2, 0, 0, 0, 4,
+   9, 5, 9, 2, 6, 3, 1, 0,
+   0, 2, 3, 0, 6, 13, 0, 2,
+};
+
+static const Stopword slots[] = {
+   {(const Byte *)"no", 2},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"after", 5},
+   {NULL, 0},
+   {(const Byte *)"itself", 6},
+   {(const Byte *)"nor", 3},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"yourselves", 10},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"then", 4},
+   {(const Byte *)"here", 4},
+   {(const Byte *)"as", 2},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"while", 5},
+   {NULL, 0},
+   {(const Byte *)"has", 3},
+   {(const Byte *)"again", 5},
+   {(const Byte *)"why", 3},
+   {(const Byte *)"by", 2},
+   {(const Byte *)"are", 3},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"into", 4},
+   {(const Byte *)"ours", 4},
+   {NULL, 0},
+   {(const Byte *)"themselves", 10},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"they", 4},
+   {(const Byte *)"an", 2},
+   {NULL, 0},
+   {(const Byte *)"any", 3},
+   {NULL, 0},
+   {(const Byte *)"where", 5},
+   {(const Byte *)"but", 3},
+   {(const Byte *)"all", 3},
+   {(const Byte *)"or", 2},
+   {NULL, 0},
+   {(const Byte *)"yours", 5},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"against", 7},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"had", 3},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"these", 5},
+   {NULL, 0},
+   {(const Byte *)"not", 3},
+   {(const Byte *)"himself", 7},
+   {(const Byte *)"have", 4},
+   {(const Byte *)"some", 4},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"and", 3},
+   {(const Byte *)"too", 3},
+   {(const Byte *)"were", 4},
+   {NULL, 0},
+   {(const Byte *)"yourself", 8},
+   {(const Byte *)"who", 3},
+   {(const Byte *)"them", 4},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"me", 2},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"under", 5},
+   {NULL, 0},
+   {(const Byte *)"down", 4},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"because", 7},
+   {(const Byte *)"few", 3},
+   {(const Byte *)"her", 3},
+   {NULL, 0},
+   {(const Byte *)"same", 4},
+   {(const Byte *)"will", 4},
+   {(const Byte *)"my", 2},
+   {(const Byte *)"during", 6},
+   {NULL, 0},
+   {(const Byte *)"own", 3},
+   {NULL, 0},
+   {(const Byte *)"having", 6},
+   {NULL, 0},
+   {(const Byte *)"of", 2},
+   {(const Byte *)"was", 3},
+   {NULL, 0},
+   {(const Byte *)"their", 5},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"i", 1},
+   {(const Byte *)"over", 4},
+   {(const Byte *)"him", 3},
+   {NULL, 0},
+   {(const Byte *)"his", 3},
+   {(const Byte *)"is", 2},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"once", 4},
+   {NULL, 0},
+   {(const Byte *)"theirs", 6},
+   {(const Byte *)"than", 4},
+   {NULL, 0},
+   {(const Byte *)"does", 4},
+   {NULL, 0},
+   {(const Byte *)"very", 4},
+   {(const Byte *)"it", 2},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"through", 7},
+   {(const Byte *)"most", 4},
+   {(const Byte *)"each", 4},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"those", 5},
+   {(const Byte *)"whom", 4},
+   {(const Byte *)"there", 5},
+   {(const Byte *)"other", 5},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"what", 4},
+   {(const Byte *)"up", 2},
+   {(const Byte *)"out", 3},
+   {NULL, 0},
+   {(const Byte *)"doing", 5},
+   {(const Byte *)"above", 5},
+   {(const Byte *)"off", 3},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"between", 7},
+   {NULL, 0},
+   {(const Byte *)"below", 5},
+   {(const Byte *)"am", 2},
+   {(const Byte *)"at", 2},
+   {(const Byte *)"be", 2},
+   {(const Byte *)"when", 4},
+   {(const Byte *)"now", 3},
+   {(const Byte *)"on", 2},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"in", 2},
+   {(const Byte *)"so", 2},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"ourselves", 9},
+   {NULL, 0},
+   {(const Byte *)"before", 6},
+   {(const Byte *)"a", 1},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"you", 3},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"such", 4},
+   {NULL, 0},
+   {(const Byte *)"she", 3},
+   {NULL, 0},
+   {(const Byte *)"being", 5},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"this", 4},
+   {(const Byte *)"further", 7},
+   {NULL, 0},
+   {(const Byte *)"hers", 4},
+   {NULL, 0},
+   {(const Byte *)"about", 5},
+   {NULL, 0},
+   {(const Byte *)"we", 2},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"if", 2},
+   {(const Byte *)"to", 2},
+   {(const Byte *)"how", 3},
+   {(const Byte *)"did", 3},
+   {(const Byte *)"just", 4},
+   {NULL, 0},
+   {(const Byte *)"until", 5},
+   {(const Byte *)"would", 5},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"from", 4},
+   {NULL, 0},
+   {(const Byte *)"for", 3},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"that", 4},
+   {(const Byte *)"should", 6},
+   {NULL, 0},
+   {(const Byte *)"both", 4},
+   {NULL, 0},
+   {(const Byte *)"with", 4},
+   {(const Byte *)"could", 5},
+   {(const Byte *)"which", 5},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"do", 2},
+   {(const Byte *)"myself", 6},
+   {(const Byte *)"the", 3},
+   {(const Byte *)"herself", 7},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"your", 4},
+   {(const Byte *)"he", 2},
+   {NULL, 0},
+   {(const Byte *)"more", 4},
+   {(const Byte *)"its", 3},
+   {NULL, 0},
+   {(const Byte *)"been", 4},
+   {NULL, 0},
+   {NULL, 0},
+   {(const Byte *)"our", 3},
+   {(const Byte *)"can", 3},
+   {NULL, 0},
+   {(const Byte *)"only", 4},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+   {NULL, 0},
+};
+
+const StopwordSet builtinStopwords = {
+   0, 32, 255, displacements, slots, NULL
+};
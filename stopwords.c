@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stopwords.h"
+#include "myMacros.h"
+
+/* Displacements tried per bucket before starting over with another seed.
+ */
+#define MAX_DISPLACEMENT (1 << 16)
+
+/* The same functions as tools/genStopwords.py: FNV-1a seeded through the
+ * basis, and a finalizer that spreads hash ^ displacement over the slots.
+ */
+static unsigned stopHash(const Byte *bytes, unsigned length, unsigned seed)
+{
+   unsigned hash = 2166136261u ^ (seed * 0x9e3779b1u);
+   unsigned i;
+
+   for(i = 0; i < length; i++) {
+      hash ^= bytes[i];
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+static unsigned mixSlot(unsigned x)
+{
+   x ^= x >> 16;
+   x *= 0x85ebca6bu;
+   x ^= x >> 13;
+   x *= 0xc2b2ae35u;
+   x ^= x >> 16;
+   return x;
+}
+
+int isStopword(const StopwordSet *set, const Byte *bytes, unsigned length)
+{
+   unsigned hash = stopHash(bytes, length, set->seed);
+   const Stopword *slot = &set->slots[mixSlot(hash
+      ^ set->displacements[hash % set->numBuckets]) & set->mask];
+
+   /* empty slots have length 0 and words never do */
+   return slot->length == length && !memcmp(slot->bytes, bytes, length);
+}
+
+/* The bucket sizes for compareBuckets, as qsort has no context argument.
+ */
+static unsigned *sortSizes;
+
+/* Orders bucket numbers by decreasing size.
+ */
+static int compareBuckets(const void *b1, const void *b2)
+{
+   return (int)sortSizes[*(const unsigned *)b2]
+      - (int)sortSizes[*(const unsigned *)b1];
+}
+
+/* Tries to place every word with the seed. Returns 0 if some bucket finds
+ * no free displacement.
+ */
+static int placeWords(Word *words, unsigned count, unsigned seed,
+   unsigned numBuckets, unsigned mask, unsigned *displacements,
+   Stopword *slots)
+{
+   unsigned *hashes, *sizes, *starts, *members, *order, *taken;
+   unsigned i, j, b, d, size, placed = 1;
+
+   /* + 1 so an empty list allocates something */
+   MY_MALLOC(hashes, (count + 1) * sizeof(unsigned));
+   MY_CALLOC(sizes, numBuckets, unsigned);
+   MY_CALLOC(starts, numBuckets + 1, unsigned);
+   MY_MALLOC(members, (count + 1) * sizeof(unsigned));
+   MY_MALLOC(order, numBuckets * sizeof(unsigned));
+   MY_MALLOC(taken, (count + 1) * sizeof(unsigned));
+
+   /* group the words by bucket */
+   for(i = 0; i < count; i++) {
+      hashes[i] = stopHash(words[i].bytes, words[i].length, seed);
+      sizes[hashes[i] % numBuckets]++;
+   }
+   for(b = 0; b < numBuckets; b++)
+      starts[b + 1] = starts[b] + sizes[b];
+   for(i = 0; i < count; i++) {
+      b = hashes[i] % numBuckets;
+      members[starts[b + 1] - sizes[b]--] = i;
+   }
+   for(b = 0; b < numBuckets; b++) {
+      sizes[b] = starts[b + 1] - starts[b];
+      order[b] = b;
+   }
+
+   /* the biggest buckets are hardest to place, so they go first */
+   sortSizes = sizes;
+   qsort(order, numBuckets, sizeof(unsigned), compareBuckets);
+
+   for(i = 0; i < mask + 1; i++)
+      slots[i].length = 0;
+
+   for(b = 0; placed && b < numBuckets; b++) {
+      size = sizes[order[b]];
+      for(d = 0; d < MAX_DISPLACEMENT; d++) {
+         for(j = 0; j < size; j++) {
+            taken[j] = mixSlot(hashes[members[starts[order[b]] + j]] ^ d)
+               & mask;
+            if(slots[taken[j]].length != 0)
+               break;
+            /* mark it so later words of the bucket see it */
+            slots[taken[j]].length = 1;
+         }
+         if(j == size)
+            break;
+         while(j-- > 0)
+            slots[taken[j]].length = 0;
+      }
+
+      if(d == MAX_DISPLACEMENT) {
+         placed = 0;
+         break;
+      }
+      displacements[order[b]] = d;
+      for(j = 0; j < size; j++) {
+         i = members[starts[order[b]] + j];
+         slots[taken[j]].bytes = words[i].bytes;
+         slots[taken[j]].length = words[i].length;
+      }
+   }
+
+   free(hashes);
+   free(sizes);
+   free(starts);
+   free(members);
+   free(order);
+   free(taken);
+   return placed;
+}
+
+StopwordSet *buildStopwords(Word *words, unsigned count)
+{
+   StopwordSet *set;
+   Word *unique;
+   unsigned *displacements;
+   Stopword *slots;
+   unsigned i, numUnique = 0, totalLength = 0, size = 1;
+
+   /* duplicates would hash alike and never find distinct slots */
+   MY_MALLOC(unique, (count + 1) * sizeof(Word));
+   if(count > 0)
+      memcpy(unique, words, count * sizeof(Word));
+   qsort(unique, count, sizeof(Word), compareWord);
+   for(i = 0; i < count; i++)
+      if(unique[i].length > 0 && (numUnique == 0
+         || compareWord(&unique[numUnique - 1], &unique[i]) != 0)) {
+         unique[numUnique++] = unique[i];
+         totalLength += unique[i].length;
+      }
+
+   MY_CALLOC(set, 1, StopwordSet);
+   while(size < numUnique + numUnique / 4)
+      size <<= 1;
+   set->mask = size - 1;
+   set->numBuckets = numUnique / 4 + 1;
+
+   /* the set owns one copy of all the words' bytes */
+   MY_MALLOC(set->storage, totalLength + 1);
+   for(i = 0, totalLength = 0; i < numUnique; i++) {
+      memcpy(set->storage + totalLength, unique[i].bytes, unique[i].length);
+      unique[i].bytes = set->storage + totalLength;
+      totalLength += unique[i].length;
+   }
+
+   MY_CALLOC(displacements, set->numBuckets, unsigned);
+   MY_MALLOC(slots, size * sizeof(Stopword));
+   for(set->seed = 0; !placeWords(unique, numUnique, set->seed,
+      set->numBuckets, set->mask, displacements, slots); set->seed++)
+      ;
+
+   set->displacements = displacements;
+   set->slots = slots;
+   free(unique);
+   return set;
+}
+
+void freeStopwords(StopwordSet *set)
+{
+   free((void *)set->displacements);
+   free((void *)set->slots);
+   free(set->storage);
+   free(set);
+}
+
+unsigned listStopwords(const StopwordSet *set, Word *words)
+{
+   unsigned i, count = 0;
+
+   for(i = 0; i <= set->mask; i++)
+      if(set->slots[i].length != 0) {
+         words[count].bytes = (Byte *)set->slots[i].bytes;
+         words[count].length = set->slots[i].length;
+         words[count].borrowed = 1;
+         count++;
+      }
+   return count;
+}
@@ -0,0 +1,57 @@
+#ifndef STOPWORDS_H
+#define STOPWORDS_H
+
+#include <stddef.h>
+#include "getWord.h"
+
+/* Stopword sets for filtering words before they reach the table.
+ *
+ * A set is a perfect hash table built by hash and displace: a word's hash
+ * picks a bucket, the bucket's displacement is mixed into the same hash to
+ * pick the slot, and the displacements were searched so that no two words
+ * share a slot. Checking a word therefore costs one hash of its bytes and
+ * one compare, whether it is a stopword or not.
+ *
+ * The built-in English list is generated into stopwordTable.c at build
+ * time by tools/genStopwords.py; user lists are built the same way at
+ * startup by buildStopwords.
+ */
+typedef struct {
+   const Byte *bytes;
+   unsigned length;
+} Stopword;
+
+typedef struct {
+   unsigned seed;
+   unsigned numBuckets;
+   unsigned mask;
+   const unsigned *displacements;
+   const Stopword *slots;
+   Byte *storage;
+} StopwordSet;
+
+extern const StopwordSet builtinStopwords;
+
+/* Description: Builds a set from lowercase words. Duplicates are allowed.
+ *
+ * Parameters:
+ *    words, count: The words; only their bytes are copied.
+ *
+ * Return: The new set, freed with freeStopwords.
+ */
+StopwordSet *buildStopwords(Word *words, unsigned count);
+
+void freeStopwords(StopwordSet *set);
+
+/* Description: Appends the words of the set to the array, for merging sets.
+ *
+ * Return: The number of words appended. The array must have room for
+ *    set->mask + 1 words; the bytes are not copied.
+ */
+unsigned listStopwords(const StopwordSet *set, Word *words);
+
+/* Return: 1 if the word is in the set, otherwise 0.
+ */
+int isStopword(const StopwordSet *set, const Byte *bytes, unsigned length);
+
+#endif
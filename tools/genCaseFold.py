@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+"""Generates caseFoldTable.c, the Unicode case folding table used by
+utf8Fold.c, from the Unicode database that ships with Python.
+
+    python3 tools/genCaseFold.py > caseFoldTable.c
+
+str.casefold() applies the C (common) and F (full) mappings of
+CaseFolding.txt, so e.g. U+00DF and U+1E9E both fold to "ss". ASCII is
+left out: utf8Fold handles it with tolower.
+"""
+import sys
+import unicodedata
+
+rows = []
+for cp in range(0x80, 0x110000):
+    if 0xD800 <= cp < 0xE000:
+        continue
+    folded = chr(cp).casefold()
+    if folded != chr(cp):
+        fold = [ord(c) for c in folded] + [0] * (3 - len(folded))
+        rows.append((cp, fold))
+
+out = sys.stdout
+out.write("/* Generated by tools/genCaseFold.py from Unicode %s - do not edit.\n"
+          " */\n" % unicodedata.unidata_version)
+out.write('#include "utf8Fold.h"\n\n')
+out.write("const CaseFold caseFoldTable[] = {\n")
+for cp, fold in rows:
+    out.write("   {0x%05X, {0x%05X, 0x%05X, 0x%05X}},\n" % (cp, *fold))
+out.write("};\n\n")
+out.write("const unsigned caseFoldTableSize = %d;\n" % len(rows))
@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+"""Generates stopwordTable.c, the built-in stopword list of stopwords.c
+compiled into a perfect hash table.
+
+    python3 tools/genStopwords.py tools/stopwords.txt > stopwordTable.c
+
+The Makefile runs this whenever the list changes. The hash, the slot
+function and the table layout must match stopwords.c: every word is looked
+up with one FNV-1a hash of its bytes and one compare.
+"""
+import sys
+
+MASK = 0xFFFFFFFF
+
+
+def stop_hash(word, seed):
+    h = (2166136261 ^ (seed * 0x9E3779B1)) & MASK
+    for b in word:
+        h ^= b
+        h = (h * 16777619) & MASK
+    return h
+
+
+def mix(x):
+    x ^= x >> 16
+    x = (x * 0x85EBCA6B) & MASK
+    x ^= x >> 13
+    x = (x * 0xC2B2AE35) & MASK
+    x ^= x >> 16
+    return x
+
+
+def table_size(count):
+    size = 1
+    while size < count + count // 4:
+        size *= 2
+    return size
+
+
+def place(words, seed, size, num_buckets):
+    hashes = [stop_hash(w, seed) for w in words]
+    buckets = [[] for _ in range(num_buckets)]
+    for i, h in enumerate(hashes):
+        buckets[h % num_buckets].append(i)
+    slots = [None] * size
+    displacements = [0] * num_buckets
+    order = sorted(range(num_buckets), key=lambda b: -len(buckets[b]))
+    for b in order:
+        for d in range(1 << 16):
+            taken = [mix(hashes[i] ^ d) & (size - 1) for i in buckets[b]]
+            if len(set(taken)) == len(taken) and \
+                    all(slots[s] is None for s in taken):
+                for i, s in zip(buckets[b], taken):
+                    slots[s] = words[i]
+                displacements[b] = d
+                break
+        else:
+            return None
+    return displacements, slots
+
+
+def main():
+    words = sorted(set(open(sys.argv[1], "rb").read().lower().split()))
+    size = table_size(len(words))
+    num_buckets = len(words) // 4 + 1
+    seed = 0
+    while True:
+        placed = place(words, seed, size, num_buckets)
+        if placed is not None:
+            break
+        seed += 1
+    displacements, slots = placed
+
+    out = sys.stdout
+    out.write("/* Generated by tools/genStopwords.py from %s - do not edit.\n"
+              " */\n" % sys.argv[1])
+    out.write('#include "stopwords.h"\n\n')
+    out.write("static const unsigned displacements[] = {\n")
+    for i in range(0, num_buckets, 8):
+        out.write("   " + ", ".join("%u" % d for d in
+                                    displacements[i:i + 8]) + ",\n")
+    out.write("};\n\n")
+    out.write("static const Stopword slots[] = {\n")
+    for word in slots:
+        if word is None:
+            out.write("   {NULL, 0},\n")
+        else:
+            out.write('   {(const Byte *)"%s", %d},\n'
+                      % (word.decode("ascii"), len(word)))
+    out.write("};\n\n")
+    out.write("const StopwordSet builtinStopwords = {\n"
+              "   %u, %u, %u, displacements, slots, NULL\n};\n"
+              % (seed, num_buckets, size - 1))
+
+
+main()
@@ -0,0 +1,133 @@
+#include <string.h>
+#include <ctype.h>
+#include "utf8Fold.h"
+
+/* 0x8080...80 for whatever the size of unsigned long is */
+#define HIGH_BITS (((unsigned long)-1 / 0xff) * 0x80)
+
+int isAscii(const Byte *bytes, unsigned length)
+{
+   unsigned long block;
+   const Byte *end = bytes + length;
+
+   for(; (unsigned)(end - bytes) >= sizeof(block); bytes += sizeof(block)) {
+      memcpy(&block, bytes, sizeof(block));
+      if(block & HIGH_BITS)
+         return 0;
+   }
+   for(; bytes < end; bytes++)
+      if(*bytes & 0x80)
+         return 0;
+   return 1;
+}
+
+/* Returns the length (2 to 4) of the valid UTF-8 sequence starting at src
+ * and stores its code point, or returns 0 if there is none. Overlong forms,
+ * surrogates and values past U+10FFFF are not valid.
+ */
+static unsigned decode(const Byte *src, const Byte *end, unsigned *codePoint)
+{
+   unsigned i, need, value, min;
+
+   if(*src >= 0xc2 && *src <= 0xdf) {
+      need = 1;
+      value = *src & 0x1f;
+      min = 0x80;
+   }
+   else if(*src >= 0xe0 && *src <= 0xef) {
+      need = 2;
+      value = *src & 0x0f;
+      min = 0x800;
+   }
+   else if(*src >= 0xf0 && *src <= 0xf4) {
+      need = 3;
+      value = *src & 0x07;
+      min = 0x10000;
+   }
+   else
+      return 0;
+
+   if((unsigned)(end - src) <= need)
+      return 0;
+   for(i = 1; i <= need; i++) {
+      if((src[i] & 0xc0) != 0x80)
+         return 0;
+      value = (value << 6) | (src[i] & 0x3f);
+   }
+   if(value < min || value > 0x10ffff || (value >= 0xd800 && value <= 0xdfff))
+      return 0;
+
+   *codePoint = value;
+   return need + 1;
+}
+
+static unsigned encode(unsigned codePoint, Byte *dst)
+{
+   if(codePoint < 0x80) {
+      dst[0] = codePoint;
+      return 1;
+   }
+   if(codePoint < 0x800) {
+      dst[0] = 0xc0 | (codePoint >> 6);
+      dst[1] = 0x80 | (codePoint & 0x3f);
+      return 2;
+   }
+   if(codePoint < 0x10000) {
+      dst[0] = 0xe0 | (codePoint >> 12);
+      dst[1] = 0x80 | ((codePoint >> 6) & 0x3f);
+      dst[2] = 0x80 | (codePoint & 0x3f);
+      return 3;
+   }
+   dst[0] = 0xf0 | (codePoint >> 18);
+   dst[1] = 0x80 | ((codePoint >> 12) & 0x3f);
+   dst[2] = 0x80 | ((codePoint >> 6) & 0x3f);
+   dst[3] = 0x80 | (codePoint & 0x3f);
+   return 4;
+}
+
+static const CaseFold *findFold(unsigned codePoint)
+{
+   unsigned lo = 0, hi = caseFoldTableSize, mid;
+
+   while(lo < hi) {
+      mid = lo + (hi - lo) / 2;
+      if(caseFoldTable[mid].codePoint < codePoint)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   if(lo < caseFoldTableSize && caseFoldTable[lo].codePoint == codePoint)
+      return &caseFoldTable[lo];
+   return NULL;
+}
+
+unsigned utf8Fold(const Byte *src, unsigned length, Byte *dst, int *hasText)
+{
+   const Byte *end = src + length;
+   Byte *out = dst;
+   const CaseFold *fold;
+   unsigned size, codePoint, i;
+
+   *hasText = 0;
+   while(src < end) {
+      if(*src < 0x80) {
+         *out++ = tolower(*src++);
+         continue;
+      }
+      if(0 == (size = decode(src, end, &codePoint))) {
+         *out++ = *src++;
+         continue;
+      }
+
+      *hasText = 1;
+      if(NULL == (fold = findFold(codePoint))) {
+         memcpy(out, src, size);
+         out += size;
+      }
+      else
+         for(i = 0; i < 3 && fold->fold[i] != 0; i++)
+            out += encode(fold->fold[i], out);
+      src += size;
+   }
+   return out - dst;
+}
@@ -0,0 +1,51 @@
+#ifndef UTF8FOLD_H
+#define UTF8FOLD_H
+
+#include "getWord.h"
+
+/* UTF-8 aware case folding for the --utf8 mode.
+ *
+ * getWord and getWordSpan only lowercase ASCII. In UTF-8 mode words that
+ * contain any byte >= 0x80 are folded again with utf8Fold, which maps every
+ * valid UTF-8 sequence through the Unicode case folding table (including the
+ * expanding foldings such as U+00DF -> "ss"), so "Straße" and "STRASSE" count
+ * as the same word. Bytes that are not part of a valid sequence are copied
+ * unchanged. Pure ASCII words, the common case, are recognized with a
+ * word-at-a-time check and never reach the table.
+ */
+
+/* A folded word is at most this many times longer than the original. */
+#define UTF8_FOLD_GROWTH 3
+
+/* One entry of the generated table in caseFoldTable.c, sorted by code point.
+ * Unused fold slots are 0.
+ */
+typedef struct {
+   unsigned codePoint;
+   unsigned fold[3];
+} CaseFold;
+
+extern const CaseFold caseFoldTable[];
+extern const unsigned caseFoldTableSize;
+
+/* Description: Checks whether every byte is below 0x80, a machine word at a
+ *    time.
+ *
+ * Return: 1 if the bytes are all ASCII, otherwise 0.
+ */
+int isAscii(const Byte *bytes, unsigned length);
+
+/* Description: Case folds the UTF-8 bytes into dst. ASCII is lowercased with
+ *    tolower.
+ *
+ * Parameters:
+ *    src, length: The word to fold.
+ *    dst: Output, must have room for UTF8_FOLD_GROWTH * length bytes.
+ *    hasText: Output, set when src holds at least one valid multibyte
+ *       sequence, which counts as printable text in UTF-8 mode.
+ *
+ * Return: The length of the folded word.
+ */
+unsigned utf8Fold(const Byte *src, unsigned length, Byte *dst, int *hasText);
+
+#endif
@@ -1,130 +1,1359 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 #include "hashTable.h"
 #include "getWord.h"
+#include "radixTree.h"
+#include "wordTable.h"
+#include "report.h"
+#include "mappedFile.h"
+#include "parallelSort.h"
+#include "wordSort.h"
+#include "documents.h"
+#include "keyDigest.h"
+#include "utf8Fold.h"
+#include "gzipReader.h"
+#include "fileWalk.h"
+#include "ngram.h"
+#include "stopwords.h"
+#include "frozenWords.h"
+#include "server.h"
+#include "presize.h"
+#include "hugePages.h"
 #include "qsortHTEntries.h"
 #include "myMacros.h"
 
-static FILE* openFile(const char *fname, void *ht)
+/* from getWord.c */
+void *my_realloc(void *, size_t);
+
+/* from qsortHTEntries.c */
+int compareEntry(const void *e1, const void *e2);
+
+/* The counting engine: the Word hash table by default or, with -t, the radix
+ * tree. The table takes ownership of new words, the tree copies them.
+ *
+ * The counter also owns the --mmap input mappings, which new words may point
+ * into, plus a spare Word and a scratch buffer reused for every token that
+ * turns out to be a duplicate. With --utf8 the scratch buffer also holds
+ * the folded form of every word that is not plain ASCII. With --ngram the
+ * words go through the n-gram window and the n-grams are what is counted.
+ * Stopwords are dropped before either. With --max-key N, words longer than
+ * N bytes are replaced by their digest key in the longKey buffer, see
+ * keyDigest.h. With --doc-freq the words are DocWords and every file is a
+ * document, see documents.h.
+ *
+ * Words are queued in batch and handed to wtAddBatch or rtAddBatch
+ * COUNT_BATCH at a time, see queueWord.
+ */
+#define COUNT_BATCH 32
+
+/* The queued words. Their bytes must stay put until the batch is flushed,
+ * so bytes that would have been copied are staged in a buffer first.
+ */
+typedef struct {
+   Word *words[COUNT_BATCH];
+   int copy[COUNT_BATCH];
+   unsigned count;
+   Byte *staging;
+   unsigned stagingSize;
+   unsigned stagingUsed;
+} Batch;
+
+typedef struct {
+   void *table;
+   int useTrie;
+   MappedFile *mappings;
+   Word *spare;
+   Byte *scratch;
+   unsigned scratchSize;
+   int foldUtf8;
+   NGram *ngram;
+   const StopwordSet *stopwords;
+   int countDocuments;
+   FILE *docCounts;
+   unsigned maxKey;
+   Byte *longKey;
+   Batch batch;
+} Counter;
+
+/* Files up to this size found by -r or --files-from are read with a single
+ * read() into a reused buffer instead of through stdio.
+ */
+#define SMALL_FILE (64 * 1024)
+
+/* The inputs, in command line order: a file, a directory tree (-r) or a
+ * file holding a list of paths (--files-from, "-" for stdin).
+ */
+typedef enum {
+   INPUT_FILE,
+   INPUT_TREE,
+   INPUT_LIST
+} InputKind;
+
+typedef struct {
+   InputKind kind;
+   char *path;
+} Input;
+
+typedef struct {
+   int numberOfWords;
+   int useTrie;
+   Byte *prefix;
+   unsigned prefixLength;
+   ReportFormat format;
+   int useMmap;
+   int numThreads;
+   int fastExit;
+   int foldUtf8;
+   Input *inputs;
+   int numInputs;
+   int ngram;
+   int builtinStopwords;
+   char *stopwordFile;
+   char *servePath;
+   int showMetrics;
+   int memReport;
+   unsigned projectTo;
+   int presize;
+   unsigned expectUnique;
+   unsigned reportEvery;
+   HugePageMode hugePages;
+   SortOrder sortOrder;
+   int docFreq;
+   char *docCountsPath;
+   unsigned maxKey;
+} Options;
+
+/* The --report-every thread, which writes reports from snapshots of the
+ * hash table while the main thread counts.
+ */
+typedef struct {
+   Counter *counter;
+   Options *options;
+   pthread_t thread;
+   pthread_mutex_t lock;
+   pthread_cond_t stop;
+   int stopping;
+   time_t start;
+} Reporter;
+
+/* What the walk callback needs to count a file.
+ */
+typedef struct {
+   Counter *counter;
+   Options *options;
+   Byte *buffer;
+} WalkContext;
+
+/* Frees the table and everything in it, keys included.
+ */
+static void releaseTable(Counter *counter)
+{
+   if(counter->useTrie)
+      rtDestroy(counter->table);
+   else
+      wtDestroy(counter->table);
+   counter->table = NULL;
+}
+
+static void destroyCounter(Counter *counter)
+{
+   unsigned i;
+
+   /* --serve releases it early, once the words are frozen */
+   if(counter->table != NULL)
+      releaseTable(counter);
+
+   /* only now is nothing pointing into the mappings any more */
+   unmapFiles(counter->mappings);
+   free(counter->scratch);
+   free(counter->longKey);
+   free(counter->batch.staging);
+   if(counter->useTrie)
+      for(i = 0; i < COUNT_BATCH; i++)
+         free(counter->batch.words[i]);
+   if(counter->ngram != NULL)
+      ngramDestroy(counter->ngram);
+   if(counter->stopwords != NULL && counter->stopwords != &builtinStopwords)
+      freeStopwords((StopwordSet *)counter->stopwords);
+}
+
+static void inputError(const char *fname, Counter *counter)
+{
+   fprintf(stderr, "wf: %s: ", fname);
+   perror(NULL);
+   destroyCounter(counter);
+   exit(EXIT_FAILURE);
+}
+
+static void outputError(const char *fname)
+{
+   fprintf(stderr, "wf: %s: ", fname);
+   perror(NULL);
+   exit(EXIT_FAILURE);
+}
+
+static FILE *createFile(const char *fname)
+{
+   FILE *file = fopen(fname, "w");
+
+   if(file == NULL)
+      outputError(fname);
+
+   return file;
+}
+
+static FILE* openFile(const char *fname, Counter *counter)
 {
    FILE* file = fopen(fname, "r");
 
    if (file == NULL)
-   {
-      fprintf(stderr, "wf: %s: ", fname);
-      perror(NULL);
-      htDestroy(ht);
-      exit(EXIT_FAILURE);
-   }
+      inputError(fname, counter);
 
    return file;
 }
 
-void flagCases(char *arg, int *numberOfWords)
+/* Words are stored lowercase, so the prefix is folded the same way.
+ */
+static void setPrefix(Options *options, const char *prefix)
+{
+   unsigned i;
+
+   options->prefixLength = strlen(prefix);
+   MY_MALLOC(options->prefix, options->prefixLength + 1);
+   for(i = 0; i < options->prefixLength; i++)
+      options->prefix[i] = tolower((Byte)prefix[i]);
+}
+
+static void foldPrefix(Options *options)
+{
+   Byte *folded;
+   int hasText;
+
+   MY_MALLOC(folded, UTF8_FOLD_GROWTH * options->prefixLength + 1);
+   options->prefixLength = utf8Fold(options->prefix, options->prefixLength,
+      folded, &hasText);
+   free(options->prefix);
+   options->prefix = folded;
+}
+
+static void usage(void)
+{
+   fprintf(stderr, "Usage: wf [-nX] [-t] [-pPREFIX] "
+      "[--format=text|tsv|csv|json] [--mmap] [--threads=N] "
+      "[--fast-exit] [--utf8] [-r dir] [--files-from=LIST] "
+      "[--ngram K] [-s] [--stopwords FILE] [--serve SOCKET] "
+      "[--metrics] [--mem-report[=N]] [--presize] [--expect-unique N] "
+      "[--report-every SECONDS] [--huge-pages[=explicit]] "
+      "[--sort=freq|alpha|length] [--doc-freq] [--doc-counts FILE] "
+      "[--max-key N] [file...]\n");
+   exit(EXIT_FAILURE);
+}
+
+static void setNgram(Options *options, const char *value)
+{
+   if(0 >= (options->ngram = atoi(value)))
+      usage();
+}
+
+static void setExpectUnique(Options *options, const char *value)
+{
+   if(0 >= (long)(options->expectUnique = strtoul(value, NULL, 10)))
+      usage();
+}
+
+static void setReportEvery(Options *options, const char *value)
+{
+   if(0 >= (long)(options->reportEvery = strtoul(value, NULL, 10)))
+      usage();
+}
+
+static void setMaxKey(Options *options, const char *value)
+{
+   if(0 >= (long)(options->maxKey = strtoul(value, NULL, 10)))
+      usage();
+}
+
+/* The counts file is per document, so it implies --doc-freq. */
+static void setDocCounts(Options *options, char *path)
+{
+   options->docCountsPath = path;
+   options->docFreq = 1;
+}
+
+static void addInput(Options *options, InputKind kind, char *path)
+{
+   options->inputs[options->numInputs].kind = kind;
+   options->inputs[options->numInputs].path = path;
+   options->numInputs++;
+}
+
+void flagCases(char *arg, Options *options)
 {
    if(!strncmp(arg, "-n", 2))
-      sscanf(arg, "%*c%*c%d", numberOfWords);
+      sscanf(arg, "%*c%*c%d", &options->numberOfWords);
+   else if(!strcmp(arg, "-t"))
+      options->useTrie = 1;
+   else if(!strncmp(arg, "-p", 2) && arg[2] != '\0')
+      setPrefix(options, arg + 2);
+   else if(!strncmp(arg, "--format=", 9)
+      && 0 == parseReportFormat(arg + 9, &options->format))
+      ;
+   else if(!strcmp(arg, "--mmap"))
+      options->useMmap = 1;
+   else if(!strncmp(arg, "--threads=", 10)
+      && 0 < (options->numThreads = atoi(arg + 10)))
+      ;
+   else if(!strcmp(arg, "--fast-exit"))
+      options->fastExit = 1;
+   else if(!strcmp(arg, "--utf8"))
+      options->foldUtf8 = 1;
+   else if(!strncmp(arg, "--files-from=", 13) && arg[13] != '\0')
+      addInput(options, INPUT_LIST, arg + 13);
+   else if(!strncmp(arg, "--ngram=", 8))
+      setNgram(options, arg + 8);
+   else if(!strcmp(arg, "-s"))
+      options->builtinStopwords = 1;
+   else if(!strncmp(arg, "--stopwords=", 12) && arg[12] != '\0')
+      options->stopwordFile = arg + 12;
+   else if(!strncmp(arg, "--serve=", 8) && arg[8] != '\0')
+      options->servePath = arg + 8;
+   else if(!strcmp(arg, "--metrics"))
+      options->showMetrics = 1;
+   else if(!strcmp(arg, "--mem-report"))
+      options->memReport = 1;
+   else if(!strncmp(arg, "--mem-report=", 13)
+      && 0 < (options->projectTo = strtoul(arg + 13, NULL, 10)))
+      options->memReport = 1;
+   else if(!strcmp(arg, "--presize"))
+      options->presize = 1;
+   else if(!strncmp(arg, "--expect-unique=", 16))
+      setExpectUnique(options, arg + 16);
+   else if(!strncmp(arg, "--report-every=", 15))
+      setReportEvery(options, arg + 15);
+   else if(!strcmp(arg, "--huge-pages")
+      || !strcmp(arg, "--huge-pages=transparent"))
+      options->hugePages = HUGE_PAGES_TRANSPARENT;
+   else if(!strcmp(arg, "--huge-pages=explicit"))
+      options->hugePages = HUGE_PAGES_EXPLICIT;
+   else if(!strncmp(arg, "--sort=", 7)
+      && 0 == parseSortOrder(arg + 7, &options->sortOrder))
+      ;
+   else if(!strcmp(arg, "--doc-freq"))
+      options->docFreq = 1;
+   else if(!strncmp(arg, "--doc-counts=", 13) && arg[13] != '\0')
+      setDocCounts(options, arg + 13);
+   else if(!strncmp(arg, "--max-key=", 10))
+      setMaxKey(options, arg + 10);
+   else
+      usage();
+}
+
+static void parseFlags(int argc, char *argv[], Options *options)
+{
+   int i;
+
+   /* there are never more inputs than arguments */
+   MY_MALLOC(options->inputs, argc * sizeof(Input));
+
+   for(i = 1; i < argc; i++)
+      if(!strcmp(argv[i], "-r") && i + 1 < argc)
+         addInput(options, INPUT_TREE, argv[++i]);
+      else if(!strcmp(argv[i], "--ngram") && i + 1 < argc)
+         setNgram(options, argv[++i]);
+      else if(!strcmp(argv[i], "--stopwords") && i + 1 < argc)
+         options->stopwordFile = argv[++i];
+      else if(!strcmp(argv[i], "--serve") && i + 1 < argc)
+         options->servePath = argv[++i];
+      else if(!strcmp(argv[i], "--expect-unique") && i + 1 < argc)
+         setExpectUnique(options, argv[++i]);
+      else if(!strcmp(argv[i], "--report-every") && i + 1 < argc)
+         setReportEvery(options, argv[++i]);
+      else if(!strcmp(argv[i], "--doc-counts") && i + 1 < argc)
+         setDocCounts(options, argv[++i]);
+      else if(!strcmp(argv[i], "--max-key") && i + 1 < argc)
+         setMaxKey(options, argv[++i]);
+      else if(!strncmp(argv[i], "-", 1))
+         flagCases(argv[i], options);
+      else
+         addInput(options, INPUT_FILE, argv[i]);
+
+   /* --utf8 may come after -p */
+   if(options->foldUtf8 && options->prefix != NULL)
+      foldPrefix(options);
+
+   /* the radix tree's leaves have no room for document stamps */
+   if(options->docFreq && options->useTrie) {
+      fprintf(stderr, "wf: --doc-freq and --doc-counts need the hash "
+         "table, not -t\n");
+      usage();
+   }
+}
+
+/* Adds to the hash table. hash is only used for n-grams, whose hash
+ * ngramPush already combined from the token hashes.
+ */
+static unsigned counterAdd(Counter *counter, Word *word, unsigned hash)
+{
+   if(counter->ngram != NULL)
+      return wtAddHashed(counter->table, word, hash);
+   return wtAdd(counter->table, word);
+}
+
+/* Starts the hash table at the size for --expect-unique N or, with
+ * --presize, for the vocabulary estimated from samples of the input files.
+ * Directory trees, file lists and standard input are not sampled.
+ */
+static void presizeTable(Counter *counter, Options *options)
+{
+   unsigned expected = options->expectUnique;
+   char **paths;
+   int i, numPaths = 0;
+
+   if(counter->useTrie)
+      return;
+
+   if(expected == 0 && options->presize) {
+      MY_MALLOC(paths, (options->numInputs + 1) * sizeof(char *));
+      for(i = 0; i < options->numInputs; i++)
+         if(options->inputs[i].kind == INPUT_FILE)
+            paths[numPaths++] = options->inputs[i].path;
+      expected = estimateUnique(paths, numPaths, options->ngram);
+      free(paths);
+   }
+
+   if(expected > 0)
+      wtReserve(counter->table, expected);
+   if(options->showMetrics)
+      fprintf(stderr, "wf: presized for %u unique, %u buckets\n", expected,
+         wtCapacity(counter->table));
+}
+
+static unsigned counterUniqueEntries(Counter *counter)
+{
+   return counter->useTrie ? rtUniqueEntries(counter->table)
+      : wtUniqueEntries(counter->table);
+}
+
+static unsigned counterTotalEntries(Counter *counter)
+{
+   return counter->useTrie ? rtTotalEntries(counter->table)
+      : wtTotalEntries(counter->table);
+}
+
+/* Key memory comes from the table's region, which wtDestroy releases in one
+ * go. Aligned memory is for Words, the rest for key bytes.
+ */
+static void *counterAllocate(Counter *counter, size_t size, int aligned)
+{
+   void *memory;
+   MemCategory category = aligned ? MEM_WORDS : MEM_KEYS;
+
+   memory = aligned ? wtAllocate(counter->table, size)
+      : wtAllocateBytes(counter->table, size);
+   memCount(category, size);
+   return memory;
+}
+
+/* Returns a Word for the table, a DocWord with --doc-freq and a
+ * DocCountWord when --doc-counts also writes the counts in each document.
+ * The tree only ever sees the batch's own Words, which it copies, so those
+ * are malloced once and freed with the counter.
+ */
+static Word *newWord(Counter *counter)
+{
+   DocWord *word;
+   Word *plain;
+
+   if(counter->useTrie) {
+      MY_MALLOC_COUNTED(plain, sizeof(Word), MEM_WORDS);
+      return plain;
+   }
+
+   if(!counter->countDocuments)
+      return counterAllocate(counter, sizeof(Word), 1);
+
+   if(counter->docCounts != NULL) {
+      word = counterAllocate(counter, sizeof(DocCountWord), 1);
+      ((DocCountWord *)word)->inDocument = 0;
+   }
+   else
+      word = counterAllocate(counter, sizeof(DocWord), 1);
+   word->lastDocument = word->documents = 0;
+   return &word->word;
+}
+
+/* Adds the queued words to the table. New ones get their own copy of the
+ * bytes, duplicates leave their Word in place for the next batch.
+ */
+static void flushBatch(Counter *counter)
+{
+   Batch *batch = &counter->batch;
+   unsigned freqs[COUNT_BATCH];
+   unsigned i;
+   Byte *bytes;
+
+   /* the tree copies new words, the batch keeps its Words */
+   if(counter->useTrie) {
+      rtAddBatch(counter->table, batch->words, batch->count, freqs);
+      batch->count = 0;
+      batch->stagingUsed = 0;
+      return;
+   }
+
+   wtAddBatch(counter->table, batch->words, batch->count, freqs);
+
+   for(i = 0; i < batch->count; i++)
+      if(freqs[i] == 1) {
+         if(batch->copy[i]) {
+            bytes = counterAllocate(counter, batch->words[i]->length, 0);
+            memcpy(bytes, batch->words[i]->bytes, batch->words[i]->length);
+            batch->words[i]->bytes = bytes;
+         }
+         batch->words[i] = NULL;
+      }
+
+   batch->count = 0;
+   batch->stagingUsed = 0;
+
+   /* the new words' bytes are final, a snapshot may see them */
+   wtQuiesce(counter->table);
+}
+
+/* Queues a word instead of adding it right away, so wtAddBatch or
+ * rtAddBatch can overlap the cache misses of many words.
+ */
+static void queueWord(Counter *counter, Byte *bytes, unsigned length,
+   int copy)
+{
+   Batch *batch = &counter->batch;
+   Word *word;
+
+   if(copy) {
+      if(batch->stagingUsed + length > batch->stagingSize) {
+         flushBatch(counter);
+         if(length > batch->stagingSize) {
+            free(batch->staging);
+            batch->stagingSize = MAX(length, MAX(2 * batch->stagingSize,
+               SMALL_FILE));
+            MY_MALLOC(batch->staging, batch->stagingSize);
+         }
+      }
+      memcpy(batch->staging + batch->stagingUsed, bytes, length);
+      bytes = batch->staging + batch->stagingUsed;
+      batch->stagingUsed += length;
+   }
+
+   if(batch->words[batch->count] == NULL)
+      batch->words[batch->count] = newWord(counter);
+   word = batch->words[batch->count];
+   word->bytes = bytes;
+   word->length = length;
+   word->borrowed = !copy;
+   batch->copy[batch->count++] = copy;
+
+   if(batch->count == COUNT_BATCH)
+      flushBatch(counter);
+}
+
+/* Replaces a word longer than --max-key by its digest key. Returns whether
+ * it did.
+ */
+static int limitKey(Counter *counter, Byte **bytes, unsigned *length)
+{
+   if(counter->maxKey == 0 || *length <= counter->maxKey)
+      return 0;
+   *length = digestKey(*bytes, *length, counter->maxKey, counter->longKey);
+   *bytes = counter->longKey;
+   return 1;
+}
+
+/* Counts the word. The bytes are only looked at unless the word is new: then
+ * they are copied into counter-owned memory when copy is set, otherwise the
+ * table keeps pointing at them (borrowed). Duplicates reuse the spare or
+ * queued Word and cost no allocation at all, and neither do stopwords.
+ * Words go through the batch, see queueWord. The radix tree copies new
+ * words itself.
+ *
+ * With --ngram the word only enters the window, and the n-gram it completes
+ * (if any) is counted instead, copied when new since the window is reused.
+ */
+static void countWord(Counter *counter, Byte *bytes, unsigned length,
+   int copy)
+{
+   Word *word = counter->spare;
+   unsigned hash = 0;
+
+   if(counter->stopwords != NULL
+      && isStopword(counter->stopwords, bytes, length))
+      return;
+
+   if(limitKey(counter, &bytes, &length))
+      copy = 1;
+
+   if(counter->ngram != NULL) {
+      if(!ngramPush(counter->ngram, bytes, length, &bytes, &length, &hash))
+         return;
+      copy = 1;
+   }
+
+   /* n-grams carry their own hash, which wtAddBatch does not take */
+   if(counter->ngram == NULL || counter->useTrie) {
+      queueWord(counter, bytes, length, copy);
+      return;
+   }
+
+   if(word == NULL)
+      word = newWord(counter);
+
+   word->bytes = bytes;
+   word->length = length;
+   word->borrowed = !copy;
+
+   if( 1 < counterAdd(counter, word, hash) )
+      counter->spare = word;
    else {
-      fprintf(stderr, "Usage: wf [-nX] [file...]\n");
-      exit(EXIT_FAILURE);
+      /* The table now holds word; swapping in a private copy of identical
+       * bytes leaves its hash and position unchanged.
+       */
+      counter->spare = NULL;
+      if(copy) {
+         word->bytes = counterAllocate(counter, length, 0);
+         memcpy(word->bytes, bytes, length);
+      }
    }
+
+   /* snapshots see new words only once their bytes are final */
+   wtQuiesce(counter->table);
 }
 
-static void parseFlags(int argc, char *argv[], int *numberOfWords)
+static void reserveScratch(Counter *counter, unsigned size)
 {
-   int i;
-   for(i = 0; i < argc; i++)
-      if(!strncmp(argv[i], "-", 1))
-         flagCases(argv[i], numberOfWords);
+   if(counter->scratchSize < size) {
+      free(counter->scratch);
+      counter->scratchSize = MAX(size, 2 * counter->scratchSize);
+      MY_MALLOC(counter->scratch, counter->scratchSize);
+   }
+}
+
+/* Folds a word that is not plain ASCII into the scratch buffer for --utf8.
+ * Returns 0 if the word is not counted because it has neither printable
+ * ASCII nor a valid UTF-8 character.
+ */
+static int foldUtf8Word(Counter *counter, Byte *bytes, unsigned length,
+   int hasPrintable, unsigned *foldedLength)
+{
+   int hasText;
+
+   reserveScratch(counter, UTF8_FOLD_GROWTH * length);
+   *foldedLength = utf8Fold(bytes, length, counter->scratch, &hasText);
+   return hasPrintable || hasText;
+}
+
+void addWordToTable(Counter *counter, Byte **word, unsigned wordLength,
+   int hasPrintable){
+
+   unsigned foldedLength;
+
+   if(counter->foldUtf8 && !isAscii(*word, wordLength)) {
+      if(foldUtf8Word(counter, *word, wordLength, hasPrintable,
+         &foldedLength))
+         countWord(counter, counter->scratch, foldedLength, 1);
+   }
+   else if(hasPrintable)
+      countWord(counter, *word, wordLength, 1);
+   free(*word);
 }
 
-void addWordToTable(void *ht, Byte **word, unsigned wordLength){
+/* Counts a word that is a span of an input buffer. With borrow set (a mapped
+ * file) already lowercase words are stored as the span itself, otherwise
+ * they are copied when new. Others are folded into the scratch buffer and
+ * only copied out of it when they turn out to be new.
+ */
+static void addSpanToTable(Counter *counter, Byte *bytes, unsigned length,
+   int hasPrintable, int hasUpper, int borrow)
+{
+   unsigned i;
 
-   Word *wordStruct;
-   MY_MALLOC(wordStruct, sizeof(Word));
+   if(counter->foldUtf8 && !isAscii(bytes, length)) {
+      if(foldUtf8Word(counter, bytes, length, hasPrintable, &i))
+         countWord(counter, counter->scratch, i, 1);
+      return;
+   }
 
-   wordStruct->length = wordLength;
-   wordStruct->bytes = (*word);
+   if(!hasPrintable)
+      return;
 
-   if( 1 < htAdd(ht, wordStruct) ){
-      free(wordStruct->bytes);
-      free(wordStruct);
+   if(!hasUpper) {
+      countWord(counter, bytes, length, !borrow);
+      return;
    }
+
+   reserveScratch(counter, length);
+   for(i = 0; i < length; i++)
+      counter->scratch[i] = tolower(bytes[i]);
+   countWord(counter, counter->scratch, length, 1);
 }
 
-void getWordSingleFile(char *arg, void *ht)
+/* Counts every word of the buffer. borrow is passed on to addSpanToTable.
+ */
+static void getWordBuffer(Counter *counter, Byte *start, Byte *end,
+   int borrow)
+{
+   Byte *cursor = start;
+   Byte *word;
+   unsigned wordLength;
+   int hasPrintable, hasUpper;
+
+   while(EOF != getWordSpan(&cursor, end, &word, &wordLength,
+      &hasPrintable, &hasUpper))
+      addSpanToTable(counter, word, wordLength, hasPrintable, hasUpper,
+         borrow);
+}
+
+static void appendBytes(Byte **buffer, unsigned *size, unsigned *length,
+   const Byte *bytes, unsigned count)
+{
+   Byte *grown;
+
+   if(*length + count > *size) {
+      *size = MAX(*length + count, 2 * *size);
+      MY_MALLOC(grown, *size);
+      if(*length > 0)
+         memcpy(grown, *buffer, *length);
+      free(*buffer);
+      *buffer = grown;
+   }
+   memcpy(*buffer + *length, bytes, count);
+   *length += count;
+}
+
+static void addCarryToTable(Counter *counter, Byte *carry, unsigned length)
+{
+   Byte *cursor = carry, *word;
+   unsigned wordLength;
+   int hasPrintable, hasUpper;
+
+   getWordSpan(&cursor, carry + length, &word, &wordLength, &hasPrintable,
+      &hasUpper);
+   addSpanToTable(counter, word, wordLength, hasPrintable, hasUpper, 0);
+}
+
+/* Counts the words of a gzip stream block by block while the reader's
+ * thread inflates the next ones. A word cut by the end of a block is
+ * gathered in a carry buffer until the whitespace that ends it arrives.
+ */
+static void getWordGzipFile(GzipReader *reader, Counter *counter)
+{
+   Byte *block, *cursor, *end, *word, *carry = NULL;
+   unsigned length, wordLength, carrySize = 0, carryLength = 0;
+   int hasPrintable, hasUpper;
+
+   while(NULL != (block = gzipNextBlock(reader, &length))) {
+      cursor = block;
+      end = block + length;
+
+      if(carryLength > 0) {
+         while(cursor < end && !isspace(*cursor))
+            cursor++;
+         appendBytes(&carry, &carrySize, &carryLength, block, cursor - block);
+         if(cursor == end)
+            continue;
+         addCarryToTable(counter, carry, carryLength);
+         carryLength = 0;
+      }
+
+      while(EOF != getWordSpan(&cursor, end, &word, &wordLength,
+         &hasPrintable, &hasUpper)) {
+         if(cursor == end) {
+            appendBytes(&carry, &carrySize, &carryLength, word, wordLength);
+            break;
+         }
+         addSpanToTable(counter, word, wordLength, hasPrintable, hasUpper, 0);
+      }
+   }
+
+   if(carryLength > 0)
+      addCarryToTable(counter, carry, carryLength);
+   free(carry);
+}
+
+/* N-grams never span two files, and with --doc-freq each file is a
+ * document of its own. The words still queued belong to the one before.
+ */
+static void startFile(Counter *counter, const char *name)
+{
+   if(counter->ngram != NULL)
+      ngramReset(counter->ngram);
+
+   if(counter->countDocuments) {
+      if(counter->batch.count > 0)
+         flushBatch(counter);
+      if(currentDocument > 0)
+         endDocument();
+      startDocument(name, counter->docCounts);
+   }
+}
+
+/* Counts the open file, named arg (NULL for stdin), and closes it.
+ */
+static void getWordOpenFile(FILE *file, const char *arg, Counter *counter,
+   Options *options)
 {
    Byte *word;
    unsigned wordLength = 0;
    int hasPrintable;
-   FILE *file;
+   MappedFile *mapping;
+   GzipReader *reader;
 
+   startFile(counter, arg == NULL ? "-" : arg);
+   if(isGzip(file)) {
+      reader = gzipOpen(file, arg);
+      getWordGzipFile(reader, counter);
+      gzipClose(reader);
+      fclose(file);
+      return;
+   }
+
+   if(options->useMmap
+      && NULL != (mapping = mapFile(file, &counter->mappings))) {
+      getWordBuffer(counter, mapping->start, mapping->end, 1);
+      fclose(file);
+      return;
+   }
+
+   while(EOF != getWord(file, &word, &wordLength, &hasPrintable))
+      addWordToTable(counter, &word, wordLength, hasPrintable);
+
+   /* an empty last word was already freed by getWord's realloc */
+   if(wordLength > 0)
+      addWordToTable(counter, &word, wordLength, hasPrintable);
+
+   fclose(file);
+}
+
+void getWordSingleFile(char *arg, Counter *counter, Options *options)
+{
    if(arg == NULL)
-      file = stdin;
+      getWordOpenFile(stdin, NULL, counter, options);
    else
-      file = openFile(arg, ht);
+      getWordOpenFile(openFile(arg, counter), arg, counter, options);
+}
 
-   while(EOF != getWord(file, &word, &wordLength, &hasPrintable)){
-      if(hasPrintable)
-         addWordToTable(ht, &word, wordLength);
-      else
-         free(word);
+/* Reads the file into the buffer. Returns its length, or -1 if reading
+ * fails or the file does not fit (it grew since it was stat'ed).
+ */
+static ssize_t readSmallFile(int fd, Byte *buffer, size_t size)
+{
+   size_t length = 0;
+   ssize_t got;
+
+   while(length < size) {
+      if(0 > (got = read(fd, buffer + length, size - length))) {
+         if(errno == EINTR)
+            continue;
+         return -1;
+      }
+      if(got == 0)
+         return length;
+      length += got;
    }
+   return -1;
+}
 
-   if(hasPrintable)
-      addWordToTable(ht, &word, wordLength);
+/* The FNInputFile for -r and --files-from. Small files take one read();
+ * large, gzip or misbehaving ones go through the same path as files named
+ * on the command line.
+ */
+static void getWordWalkedFile(int fd, const char *path, off_t size,
+   void *context)
+{
+   WalkContext *walk = (WalkContext *)context;
+   ssize_t length = -1;
+   FILE *file;
 
-   fclose(file);
+   if(size < SMALL_FILE)
+      length = readSmallFile(fd, walk->buffer, SMALL_FILE);
+
+   /* the gzip magic bytes */
+   if(length >= 0 && !(length >= 2 && walk->buffer[0] == 0x1f
+      && walk->buffer[1] == 0x8b)) {
+      startFile(walk->counter, path);
+      getWordBuffer(walk->counter, walk->buffer, walk->buffer + length, 0);
+      close(fd);
+      return;
+   }
+
+   if(0 > lseek(fd, 0, SEEK_SET) || NULL == (file = fdopen(fd, "r")))
+      inputError(path, walk->counter);
+   getWordOpenFile(file, path, walk->counter, walk->options);
+}
+
+static void walkInput(FileWalk *walk, Input *input, Counter *counter)
+{
+   FILE *list;
+
+   if(input->kind == INPUT_TREE) {
+      if(0 != walkPath(walk, input->path))
+         inputError(input->path, counter);
+      return;
+   }
+
+   list = strcmp(input->path, "-") ? openFile(input->path, counter) : stdin;
+   walkList(walk, list);
+   if(list != stdin)
+      fclose(list);
 }
 
-void getWordAllFiles(void *ht, int argc, char *argv[])
+void getWordAllFiles(Counter *counter, Options *options)
 {
    int i;
-   for(i = 1; i < argc; i++)
-      if(strncmp(argv[i], "-", 1))
-         getWordSingleFile(argv[i], ht);
-   /* read from stdin */
-   if(i == 1)
-      getWordSingleFile(NULL, ht);
+   FileWalk *walk = NULL;
+   WalkContext context;
+
+   context.counter = counter;
+   context.options = options;
+   context.buffer = NULL;
+
+   for(i = 0; i < options->numInputs; i++) {
+      if(options->inputs[i].kind == INPUT_FILE) {
+         /* the walk's files come first, in argument order */
+         if(walk != NULL)
+            walkFlush(walk);
+         getWordSingleFile(options->inputs[i].path, counter, options);
+         continue;
+      }
+      if(walk == NULL) {
+         MY_MALLOC(context.buffer, SMALL_FILE);
+         walk = walkCreate(getWordWalkedFile, &context);
+      }
+      walkInput(walk, &options->inputs[i], counter);
+   }
+
+   if(walk != NULL) {
+      walkDestroy(walk);
+      free(context.buffer);
+   }
+
+   /* read from stdin, also when only flags were given */
+   if(options->numInputs == 0)
+      getWordSingleFile(NULL, counter, options);
+
+   if(counter->batch.count > 0)
+      flushBatch(counter);
+   if(counter->countDocuments && currentDocument > 0)
+      endDocument();
 }
 
-void printWords(void *ht, HTEntry *entries, int size)
+static void collectPrefixEntry(HTEntry *entry, void *context)
 {
-   int i, j;
-   unsigned length;
+   HTEntry **next = (HTEntry **)context;
+   *((*next)++) = *entry;
+}
+
+static int hasPrefix(HTEntry *entry, Options *options)
+{
+   Word *word = (Word *)entry->data;
+   return word->length >= options->prefixLength
+      && !memcmp(word->bytes, options->prefix, options->prefixLength);
+}
+
+/* Drops the hash table entries without the -p prefix, if one was given. */
+static void filterPrefix(HTEntry *entries, unsigned *size, Options *options)
+{
+   HTEntry *next = entries;
+   unsigned i;
+
+   if(options->prefix == NULL)
+      return;
+   for(i = 0; i < *size; i++)
+      if(hasPrefix(&entries[i], options))
+         *(next++) = entries[i];
+   *size = next - entries;
+}
+
+/* Returns the entries to report, restricted to the -p prefix when given. The
+ * radix tree only walks the matching subtree, the hash table is filtered.
+ */
+static HTEntry *collectEntries(Counter *counter, Options *options,
+   unsigned *size)
+{
+   HTEntry *entries, *next;
+
+   if(counter->useTrie && options->prefix != NULL) {
+      *size = 0;
+      if(rtUniqueEntries(counter->table) == 0)
+         return NULL;
+      MY_MALLOC_COUNTED(entries,
+         rtUniqueEntries(counter->table) * sizeof(HTEntry), MEM_RESULTS);
+      next = entries;
+      rtIteratePrefix(counter->table, options->prefix, options->prefixLength,
+         collectPrefixEntry, &next);
+      *size = next - entries;
+      return entries;
+   }
+
+   if(counter->useTrie)
+      return rtToArray(counter->table, size);
+
+   entries = wtToArray(counter->table, size);
+   filterPrefix(entries, size, options);
+   return entries;
+}
+
+/* Writes the --metrics summary of the counting engine to stderr.
+ */
+static void printMetrics(Counter *counter)
+{
+   TTMetrics metrics;
+
+   fprintf(stderr, "wf: %u unique, %u total\n",
+      counterUniqueEntries(counter), counterTotalEntries(counter));
+   if(counter->useTrie)
+      return;
+
+   metrics = wtMetrics(counter->table);
+   fprintf(stderr, "wf: %u buckets, %u chains, longest %u, average %.2f\n",
+      wtCapacity(counter->table), metrics.chains.numberOfChains,
+      metrics.chains.maxChainLength, metrics.chains.avgChainLength);
+   fprintf(stderr, "wf: front cache %u slots, %u hits, hit rate %.1f%%\n",
+      metrics.cacheSlots, metrics.cacheHits, 100 * metrics.cacheHitRate);
+   fprintf(stderr, "wf: %u chains converted to trees\n",
+      metrics.treeConversions);
+   fprintf(stderr, "wf: %u rehashes\n", metrics.rehashes);
+}
+
+/* Writes the --mem-report to stderr. Unless a vocabulary was given, the
+ * projection is for ten times the words counted. The table holds V words
+ * in the first size of at least V buckets (the load factor is 1).
+ */
+static void printMemReport(Counter *counter, Options *options,
+   unsigned sizes[], int numSizes)
+{
+   unsigned unique = counterUniqueEntries(counter);
+   double vocabulary = options->projectTo;
+   double buckets = 0, previous = 0;
+   int i;
+
+   if(vocabulary == 0)
+      vocabulary = MIN(10.0 * unique, 4294967295.0);
 
-   printf("%u unique words found in %u total words\n", htUniqueEntries(ht),
-      htTotalEntries(ht));
+   if(!counter->useTrie) {
+      for(i = 0; i < numSizes - 1 && sizes[i] < vocabulary; i++)
+         ;
+      buckets = sizes[i] * (double)sizeof(void *);
+      previous = i > 0 ? sizes[i - 1] * (double)sizeof(void *) : 0;
+   }
+   writeMemReport(stderr, unique, (unsigned)vocabulary, buckets, previous);
+}
+
+/* Puts the entries in --sort order. The radix tree already hands them out
+ * in key order, so with -t alpha needs no sort and length only the
+ * counting pass by length. --serve answers TOP queries, so it keeps
+ * frequency order.
+ */
+static void sortEntries(Counter *counter, Options *options,
+   HTEntry *entries, unsigned size)
+{
+   if(options->sortOrder == SORT_FREQ || options->servePath != NULL)
+      parallelSortHTEntries(entries, size, options->numThreads);
+   else if(!counter->useTrie)
+      sortEntriesByWord(entries, size, options->sortOrder);
+   else if(options->sortOrder == SORT_LENGTH)
+      sortEntriesByLength(entries, size);
+}
+
+void printWords(Counter *counter, Options *options, HTEntry *entries,
+   unsigned available)
+{
+   unsigned size = 0;
 
    /* resize so no seg fault */
-   if(size > htUniqueEntries(ht))
-      size = htUniqueEntries(ht);
-
-   for (i = 0; i < size; i++)
-   {
-      length = ((Word*)entries[i].data)->length;
-      printf("%10u - ", entries[i].frequency);
-
-      for (j = 0; j < length && j < 30; j++) {
-         if( isprint( ((Word*)entries[i].data)->bytes[j] ))
-            printf("%c", ((Word*)entries[i].data)->bytes[j]);
-         else
-            printf(".");
+   if(options->numberOfWords > 0)
+      size = MIN((unsigned)options->numberOfWords, available);
+
+   writeReport(STDOUT_FILENO, options->format,
+      counterUniqueEntries(counter), counterTotalEntries(counter),
+      counter->countDocuments ? currentDocument : 0, entries, size);
+}
+
+/* Restores the heap property below i: every entry sorts after its
+ * children, so the root is the one that sorts last.
+ */
+static void siftDown(HTEntry *heap, unsigned count, unsigned i)
+{
+   unsigned child;
+   HTEntry swap;
+
+   while((child = 2 * i + 1) < count) {
+      if(child + 1 < count && compareEntry(&heap[child + 1], &heap[child]) > 0)
+         child++;
+      if(compareEntry(&heap[child], &heap[i]) <= 0)
+         break;
+      swap = heap[i];
+      heap[i] = heap[child];
+      heap[child] = swap;
+      i = child;
+   }
+}
+
+/* Puts the count entries that sort first at the front, in order, through a
+ * heap of count entries instead of sorting all of them.
+ */
+static void selectTop(HTEntry *entries, unsigned size, unsigned count)
+{
+   unsigned i;
+
+   if(count == 0 || count >= size) {
+      qsortHTEntries(entries, MIN(count, size));
+      return;
+   }
+
+   for(i = count / 2; i-- > 0; )
+      siftDown(entries, count, i);
+   for(i = count; i < size; i++)
+      if(compareEntry(&entries[i], &entries[0]) < 0) {
+         entries[0] = entries[i];
+         siftDown(entries, count, 0);
       }
-      if( length > j )
-         printf("...");
+   qsortHTEntries(entries, count);
+}
+
+/* Writes a report of a snapshot of the hash table to stderr, headed by the
+ * time since counting started. Only the reported words are put in order,
+ * which keeps the report thread's share of the CPU small.
+ */
+static void writeSnapshotReport(Reporter *reporter)
+{
+   Counter *counter = reporter->counter;
+   Options *options = reporter->options;
+   HTEntry *entries;
+   unsigned size, unique, total, count = 0;
+
+   entries = wtSnapshot(counter->table, &size, &total);
+   unique = size;
+   filterPrefix(entries, &size, options);
+   if(options->numberOfWords > 0)
+      count = MIN((unsigned)options->numberOfWords, size);
+   selectTop(entries, size, count);
+
+   fprintf(stderr, "wf: report after %ld s\n",
+      (long)(time(NULL) - reporter->start));
+   writeReport(STDERR_FILENO, options->format, unique, total, 0, entries,
+      count);
+   free(entries);
+}
+
+static void *reportThread(void *context)
+{
+   Reporter *reporter = context;
+   struct timespec deadline;
+
+   clock_gettime(CLOCK_REALTIME, &deadline);
+   pthread_mutex_lock(&reporter->lock);
+   while(!reporter->stopping) {
+      deadline.tv_sec += reporter->options->reportEvery;
+      while(!reporter->stopping && ETIMEDOUT != pthread_cond_timedwait(
+         &reporter->stop, &reporter->lock, &deadline))
+         ;
+      if(reporter->stopping)
+         break;
+      pthread_mutex_unlock(&reporter->lock);
+      writeSnapshotReport(reporter);
+      pthread_mutex_lock(&reporter->lock);
+   }
+   pthread_mutex_unlock(&reporter->lock);
+   return NULL;
+}
+
+/* Starts the --report-every thread. The radix tree has no snapshots, so
+ * with -t there are no reports until the end.
+ */
+static void startReporter(Reporter *reporter, Counter *counter,
+   Options *options)
+{
+   reporter->counter = counter;
+   reporter->options = options;
+   reporter->stopping = 0;
+   reporter->start = time(NULL);
+   pthread_mutex_init(&reporter->lock, NULL);
+   pthread_cond_init(&reporter->stop, NULL);
 
-      printf("\n");
+   wtOnline(counter->table);
+   if(0 != pthread_create(&reporter->thread, NULL, reportThread, reporter)) {
+      fprintf(stderr, "wf: cannot start the report thread\n");
+      exit(EXIT_FAILURE);
    }
 }
 
+/* Stops the thread once counting is done, after any report it is writing.
+ */
+static void stopReporter(Reporter *reporter)
+{
+   wtOffline(reporter->counter->table);
+   pthread_mutex_lock(&reporter->lock);
+   reporter->stopping = 1;
+   pthread_cond_signal(&reporter->stop);
+   pthread_mutex_unlock(&reporter->lock);
+   pthread_join(reporter->thread, NULL);
+   pthread_mutex_destroy(&reporter->lock);
+   pthread_cond_destroy(&reporter->stop);
+}
+
+/* What a --serve lookup needs.
+ */
+typedef struct {
+   Counter *counter;
+   Options *options;
+   const FrozenWords *words;
+} QueryContext;
+
+/* Folds a query word into the scratch buffer the way input words are.
+ */
+static void foldQueryWord(Counter *counter, Byte *bytes, unsigned length,
+   Word *word)
+{
+   unsigned i;
+   int hasText;
+
+   reserveScratch(counter, UTF8_FOLD_GROWTH * length);
+   word->bytes = counter->scratch;
+   if(counter->foldUtf8 && !isAscii(bytes, length))
+      word->length = utf8Fold(bytes, length, counter->scratch, &hasText);
+   else {
+      for(i = 0; i < length; i++)
+         counter->scratch[i] = tolower(bytes[i]);
+      word->length = length;
+   }
+}
+
+/* The FNLookUp for --serve. The query is tokenized, folded and filtered
+ * like the input; with --ngram its words must make exactly one n-gram.
+ */
+static unsigned lookUpQuery(Byte *query, unsigned length, void *context)
+{
+   Counter *counter = ((QueryContext *)context)->counter;
+   Options *options = ((QueryContext *)context)->options;
+   const FrozenWords *words = ((QueryContext *)context)->words;
+   Byte *cursor = query, *token;
+   unsigned tokenLength, hash = 0;
+   int hasPrintable, hasUpper, numTokens = 0, complete = 0;
+   Word word;
+
+   if(counter->ngram != NULL)
+      ngramReset(counter->ngram);
+
+   while(EOF != getWordSpan(&cursor, query + length, &token, &tokenLength,
+      &hasPrintable, &hasUpper)) {
+      foldQueryWord(counter, token, tokenLength, &word);
+      if(counter->stopwords != NULL
+         && isStopword(counter->stopwords, word.bytes, word.length))
+         continue;
+      limitKey(counter, &word.bytes, &word.length);
+      numTokens++;
+      if(counter->ngram != NULL)
+         complete = ngramPush(counter->ngram, word.bytes, word.length,
+            &word.bytes, &word.length, &hash);
+      else
+         complete = 1;
+   }
+
+   if(!complete || numTokens != MAX(options->ngram, 1))
+      return 0;
+   return fwLookUp(words, word.bytes, word.length);
+}
+
+/* Freezes the words of the entries, sorted by frequency, then frees the
+ * entries and the table: only the frozen copy stays resident while serving.
+ */
+static void serveEntries(Counter *counter, Options *options,
+   HTEntry *entries, unsigned size)
+{
+   QueryContext context;
+   ServerData data;
+   FrozenWords *words = fwFreeze(entries, size);
+
+   data.uniqueWords = counterUniqueEntries(counter);
+   data.totalWords = counterTotalEntries(counter);
+   free(entries);
+   releaseTable(counter);
+   /* the table's memory is resident until malloc gives it back */
+#ifdef __GLIBC__
+   malloc_trim(0);
+#endif
+
+   context.counter = counter;
+   context.options = options;
+   context.words = words;
+   data.lookUp = lookUpQuery;
+   data.context = &context;
+   data.words = words;
+   serveQueries(options->servePath, &data);
+   fwDestroy(words);
+}
+
+/* Reads the stopword file's words, folded like the input words, and builds
+ * the set from them plus the built-in words when -s is also given.
+ */
+static StopwordSet *loadStopwords(Options *options, Counter *counter)
+{
+   FILE *file = openFile(options->stopwordFile, counter);
+   Word *words = NULL;
+   unsigned i, count = 0, size = 0;
+   unsigned length;
+   int hasPrintable, hasText, status;
+   Byte *bytes, *folded;
+   StopwordSet *set;
+
+   do {
+      status = getWord(file, &bytes, &length, &hasPrintable);
+      /* an empty last word was already freed by getWord's realloc */
+      if(length == 0)
+         continue;
+
+      if(options->foldUtf8 && !isAscii(bytes, length)) {
+         MY_MALLOC(folded, UTF8_FOLD_GROWTH * length);
+         length = utf8Fold(bytes, length, folded, &hasText);
+         free(bytes);
+         bytes = folded;
+      }
+
+      if(count == size) {
+         size = MAX(2 * size, 64);
+         words = my_realloc(words, size * sizeof(Word));
+      }
+      words[count].bytes = bytes;
+      words[count].length = length;
+      words[count].borrowed = 0;
+      count++;
+   } while(status != EOF);
+   fclose(file);
+
+   if(options->builtinStopwords) {
+      words = my_realloc(words,
+         (count + builtinStopwords.mask + 1) * sizeof(Word));
+      count += listStopwords(&builtinStopwords, words + count);
+   }
+
+   set = buildStopwords(words, count);
+   for(i = 0; i < count; i++)
+      destroyWord(&words[i]);
+   free(words);
+   return set;
+}
+
 int main(int argc, char *argv[]) {
 
-   HTFunctions funcs = {hashWord, compareWord, destroyWord};
    int numSizes = 26;
-   int numberOfWords = 10;
    unsigned size;
    unsigned sizes[] = {
       53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593,
@@ -133,21 +1362,69 @@ int main(int argc, char *argv[]) {
       805306457, 1610612741, 4294967295
    };
 
-   void *ht = htCreate(&funcs, sizes, numSizes, 1);
+   Options options = {10, 0, NULL, 0, REPORT_TEXT, 0, 1, 0, 0, NULL, 0, 0, 0,
+      NULL, NULL, 0, 0, 0, 0, 0, 0, HUGE_PAGES_OFF, SORT_FREQ, 0, NULL, 0};
+   Counter counter = {NULL, 0, NULL, NULL, NULL, 0, 0, NULL, NULL};
+   Reporter reporter;
+   int reporting;
    HTEntry *entries;
 
-   parseFlags(argc, argv, &numberOfWords);
+   parseFlags(argc, argv, &options);
+   seedWordHash();
+   hugePageMode = options.hugePages;
+
+   counter.useTrie = options.useTrie;
+   counter.foldUtf8 = options.foldUtf8;
+   counter.countDocuments = options.docFreq;
+   if(0 < (counter.maxKey = options.maxKey))
+      MY_MALLOC(counter.longKey, counter.maxKey + DIGEST_KEY_GROWTH);
+   if(counter.countDocuments && options.docCountsPath != NULL)
+      counter.docCounts = createFile(options.docCountsPath);
+   if(options.ngram > 0)
+      counter.ngram = ngramCreate(options.ngram);
+   if(options.stopwordFile != NULL)
+      counter.stopwords = loadStopwords(&options, &counter);
+   else if(options.builtinStopwords)
+      counter.stopwords = &builtinStopwords;
+   if(counter.useTrie)
+      counter.table = rtCreate();
+   else
+      counter.table = wtCreate(sizes, numSizes, 1);
+   presizeTable(&counter, &options);
+
+   reporting = options.reportEvery > 0 && !counter.useTrie;
+   if(reporting)
+      startReporter(&reporter, &counter, &options);
+   getWordAllFiles(&counter, &options);
+   if(counter.docCounts != NULL && 0 != fclose(counter.docCounts))
+      outputError(options.docCountsPath);
+   if(reporting)
+      stopReporter(&reporter);
+   if(options.showMetrics)
+      printMetrics(&counter);
+
+   entries = collectEntries(&counter, &options, &size);
 
-   getWordAllFiles(ht, argc, argv);
+   sortEntries(&counter, &options, entries, size);
 
-   entries = htToArray(ht, &size);
+   if(options.memReport)
+      printMemReport(&counter, &options, sizes, numSizes);
 
-   qsortHTEntries(entries, size);
+   if(options.servePath != NULL) {
+      serveEntries(&counter, &options, entries, size);
+      entries = NULL;
+   }
+   else
+      printWords(&counter, &options, entries, size);
 
-   printWords(ht, entries, numberOfWords);
+   /* The report is written, let the OS reclaim everything at once */
+   if(options.fastExit)
+      return EXIT_SUCCESS;
 
    free(entries);
-   htDestroy(ht);
+   free(options.prefix);
+   free(options.inputs);
+   destroyCounter(&counter);
 
    return EXIT_SUCCESS;
 }
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <string.h>
+#include "wordSort.h"
+#include "getWord.h"
+#include "myMacros.h"
+
+/* Groups smaller than this are insertion sorted. */
+#define SMALL_GROUP 32
+
+/* The key of a word at a depth is its byte there plus one, or ENDED once
+ * the word is shorter, so a word sorts before the words it is a prefix of.
+ */
+#define ENDED 0
+#define KEYS 257
+
+typedef unsigned short Key;
+
+int parseSortOrder(const char *name, SortOrder *order)
+{
+   if(!strcmp(name, "freq"))
+      *order = SORT_FREQ;
+   else if(!strcmp(name, "alpha"))
+      *order = SORT_ALPHA;
+   else if(!strcmp(name, "length"))
+      *order = SORT_LENGTH;
+   else
+      return -1;
+   return 0;
+}
+
+/* compareWord for words known to share their first depth bytes. */
+static int compareFrom(const Word *w1, const Word *w2, unsigned depth)
+{
+   int diff;
+   unsigned min = MIN(w1->length, w2->length);
+
+   if(min > depth
+      && (diff = memcmp(w1->bytes + depth, w2->bytes + depth, min - depth)))
+      return diff;
+   return (int)w1->length - (int)w2->length;
+}
+
+static void insertionSort(HTEntry *entries, unsigned count, unsigned depth)
+{
+   unsigned i, j;
+   HTEntry entry;
+
+   for(i = 1; i < count; i++) {
+      entry = entries[i];
+      for(j = i; j > 0 && compareFrom((Word *)entries[j - 1].data,
+         (Word *)entry.data, depth) > 0; j--)
+         entries[j] = entries[j - 1];
+      entries[j] = entry;
+   }
+}
+
+/* Returns how many bytes from depth on all the words share, at least one:
+ * the caller found they share the byte at depth.
+ */
+static unsigned sharedPrefix(HTEntry *entries, unsigned count,
+   unsigned depth)
+{
+   Word *first = (Word *)entries[0].data, *word;
+   unsigned i, j, shared = first->length - depth;
+
+   for(i = 1; i < count && shared > 1; i++) {
+      word = (Word *)entries[i].data;
+      shared = MIN(shared, word->length - depth);
+      for(j = 1; j < shared && word->bytes[depth + j]
+         == first->bytes[depth + j]; j++)
+         ;
+      shared = j;
+   }
+   return shared;
+}
+
+/* Sorts count entries that share their first depth bytes. Every group but
+ * the largest is sorted by a recursive call and the largest by the loop,
+ * so the recursion is never deeper than log2 of the entries.
+ */
+static void radixSort(HTEntry *entries, HTEntry *scratch, Key *keys,
+   unsigned count, unsigned depth)
+{
+   unsigned counts[KEYS], starts[KEYS], next[KEYS];
+   unsigned i, largest;
+   Word *word;
+
+   while(count >= SMALL_GROUP) {
+      memset(counts, 0, sizeof(counts));
+      for(i = 0; i < count; i++) {
+         word = (Word *)entries[i].data;
+         keys[i] = depth < word->length ? word->bytes[depth] + 1 : ENDED;
+         counts[keys[i]]++;
+      }
+
+      /* bytes they all share move nothing, skip all of them at once */
+      if(counts[keys[0]] == count) {
+         if(keys[0] == ENDED)
+            return;
+         depth += sharedPrefix(entries, count, depth);
+         continue;
+      }
+
+      starts[0] = next[0] = 0;
+      for(i = 1; i < KEYS; i++)
+         starts[i] = next[i] = starts[i - 1] + counts[i - 1];
+      for(i = 0; i < count; i++)
+         scratch[next[keys[i]]++] = entries[i];
+      memcpy(entries, scratch, count * sizeof(HTEntry));
+
+      /* the words that ended are equal, they stay as they are */
+      largest = 1;
+      for(i = 2; i < KEYS; i++)
+         if(counts[i] > counts[largest])
+            largest = i;
+      for(i = 1; i < KEYS; i++)
+         if(i != largest && counts[i] > 1)
+            radixSort(entries + starts[i], scratch + starts[i],
+               keys + starts[i], counts[i], depth + 1);
+
+      entries += starts[largest];
+      scratch += starts[largest];
+      keys += starts[largest];
+      count = counts[largest];
+      depth++;
+   }
+   insertionSort(entries, count, depth);
+}
+
+/* Stable counting sort by length, entries to scratch and back. */
+static void sortByLength(HTEntry *entries, HTEntry *scratch,
+   unsigned numberOfEntries)
+{
+   unsigned *next;
+   unsigned i, maxLength = 0, start = 0, count;
+
+   for(i = 0; i < numberOfEntries; i++)
+      maxLength = MAX(maxLength, ((Word *)entries[i].data)->length);
+
+   MY_CALLOC(next, maxLength + 1, unsigned);
+   for(i = 0; i < numberOfEntries; i++)
+      next[((Word *)entries[i].data)->length]++;
+   for(i = 0; i <= maxLength; i++) {
+      count = next[i];
+      next[i] = start;
+      start += count;
+   }
+   for(i = 0; i < numberOfEntries; i++)
+      scratch[next[((Word *)entries[i].data)->length]++] = entries[i];
+   memcpy(entries, scratch, numberOfEntries * sizeof(HTEntry));
+   free(next);
+}
+
+void sortEntriesByWord(HTEntry *entries, unsigned numberOfEntries,
+   SortOrder order)
+{
+   HTEntry *scratch;
+   Key *keys;
+
+   if(numberOfEntries < 2)
+      return;
+
+   MY_MALLOC_COUNTED(scratch, numberOfEntries * sizeof(HTEntry),
+      MEM_RESULTS);
+   MY_MALLOC_COUNTED(keys, numberOfEntries * sizeof(Key), MEM_RESULTS);
+
+   radixSort(entries, scratch, keys, numberOfEntries, 0);
+   if(order == SORT_LENGTH)
+      sortByLength(entries, scratch, numberOfEntries);
+
+   free(keys);
+   memFreed(MEM_RESULTS, numberOfEntries * sizeof(Key));
+   free(scratch);
+   memFreed(MEM_RESULTS, numberOfEntries * sizeof(HTEntry));
+}
+
+void sortEntriesByLength(HTEntry *entries, unsigned numberOfEntries)
+{
+   HTEntry *scratch;
+
+   if(numberOfEntries < 2)
+      return;
+
+   MY_MALLOC_COUNTED(scratch, numberOfEntries * sizeof(HTEntry),
+      MEM_RESULTS);
+   sortByLength(entries, scratch, numberOfEntries);
+   free(scratch);
+   memFreed(MEM_RESULTS, numberOfEntries * sizeof(HTEntry));
+}
@@ -0,0 +1,65 @@
+#ifndef WORDSORT_H
+#define WORDSORT_H
+
+#include "hashTable.h"
+
+/* Report orders for --sort.
+ *
+ *    SORT_FREQ:   Highest frequency first, ties by compareWord (the order of
+ *       qsortHTEntries and parallelSortHTEntries).
+ *    SORT_ALPHA:  By compareWord: byte by byte, a word before the longer
+ *       words it is a prefix of.
+ *    SORT_LENGTH: Shortest word first, words of the same length by
+ *       compareWord.
+ */
+typedef enum {
+   SORT_FREQ,
+   SORT_ALPHA,
+   SORT_LENGTH
+} SortOrder;
+
+/* Description: Maps an order name (freq, alpha or length) to its value.
+ *
+ * Return: 0 on success, -1 if the name is not a known order.
+ */
+int parseSortOrder(const char *name, SortOrder *order);
+
+/* Description: Sorts entries whose data are Words into SORT_ALPHA or
+ *    SORT_LENGTH order without comparing whole words.
+ *
+ * Notes:
+ *    1. This is an MSD radix sort: the entries are distributed by their
+ *       first byte, each group by its second byte and so on, until a group
+ *       is small enough for insertion sort from the bytes it has left. Every
+ *       pass first copies the byte of every entry into a key cache, so the
+ *       distribution itself never follows a Word pointer. The bytes every
+ *       word of a group shares, such as a common prefix, are skipped
+ *       together in one more pass and cost no moves.
+ *    2. SORT_LENGTH is a stable counting sort by length of the SORT_ALPHA
+ *       result.
+ *    3. A scratch array of the same size as entries, plus two bytes per
+ *       entry for the key cache, is allocated while sorting.
+ *
+ * Parameters:
+ *    entries: The array returned by wtToArray (or an equivalent).
+ *    numberOfEntries: The number of entries in the array.
+ *    order: SORT_ALPHA or SORT_LENGTH.
+ *
+ * Return: None
+ */
+void sortEntriesByWord(HTEntry *entries, unsigned numberOfEntries,
+   SortOrder order);
+
+/* Description: Puts entries that are already in SORT_ALPHA order, such as
+ *    those of rtToArray, into SORT_LENGTH order with the stable counting
+ *    sort alone. Allocates a scratch array of the same size while sorting.
+ *
+ * Parameters:
+ *    entries: The entries, whose data are Words.
+ *    numberOfEntries: The number of entries in the array.
+ *
+ * Return: None
+ */
+void sortEntriesByLength(HTEntry *entries, unsigned numberOfEntries);
+
+#endif
@@ -0,0 +1,40 @@
+#include <string.h>
+#include "getWord.h"
+#include "documents.h"
+
+/* Same seeded hash and ordering as hashWord and compareWord in getWord.c,
+ * in a form the compiler can inline into the table.
+ */
+static unsigned wtHashWord(const Word *word)
+{
+   unsigned hash = 2166136261u ^ wordHashSeed;
+   const Byte *bytes = word->bytes;
+   const Byte *end = bytes + word->length;
+
+   while(bytes < end) {
+      hash ^= *bytes++;
+      hash *= 16777619u;
+   }
+   return hash;
+}
+
+static int wtCompareWord(const Word *w1, const Word *w2)
+{
+   int diff;
+   unsigned min = w1->length < w2->length ? w1->length : w2->length;
+
+   if((diff = memcmp(w1->bytes, w2->bytes, min)))
+      return diff;
+   return (int)w1->length - (int)w2->length;
+}
+
+#define TT_IMPLEMENTATION
+#define TT_HASH(KEY) wtHashWord(KEY)
+#define TT_COMPARE(K1,K2) wtCompareWord(K1, K2)
+#define TT_KEYS_IN_REGION
+#define TT_COUNTED(KEY) \
+   do { \
+      if(currentDocument != 0) \
+         countInDocument((DocWord *)(KEY)); \
+   } while(0)
+#include "wordTable.h"
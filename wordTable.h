@@ -0,0 +1,24 @@
+#ifndef WORDTABLE_H
+#define WORDTABLE_H
+
+#include "getWord.h"
+
+/* The hash table specialized for Word keys, generated from
+ * hashTableTemplate.h. Provides wtTable and wtCreate, wtDestroy, wtAdd,
+ * wtAddHashed, wtAddBatch, wtLookUp, wtLookUpHashed, wtReserve, wtToArray,
+ * wtCapacity, wtUniqueEntries, wtTotalEntries and wtMetrics, which also
+ * reports the front cache hit rate, plus wtSnapshot, wtQuiesce, wtOnline
+ * and wtOffline for --report-every. Hashing and comparing words is inlined,
+ * see wordTable.c, and so is counting them in the current document for
+ * --doc-freq, see documents.h.
+ *
+ * The table owns its keys' memory: every Word added with wtAdd, and its
+ * bytes unless they are borrowed, must come from wtAllocate and
+ * wtAllocateBytes. wtDestroy then frees them all at once.
+ */
+#define TT_PREFIX wt
+#define TT_KEY Word
+#define TT_SNAPSHOTS
+#include "hashTableTemplate.h"
+
+#endif